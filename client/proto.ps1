@@ -1,8 +1,14 @@
-$path = "./node_modules/.bin/protoc-gen-ts_proto.cmd"
+$path = "./node_modules/.bin/protoc-gen-ts_proto"
 if ([System.Environment]::OSVersion.Platform -eq "Win32NT") {
     $path = ".\\node_modules\\.bin\\protoc-gen-ts_proto.cmd"
 }
 
+# the protoc from the mod's dependencies if they are installed, otherwise any on the path
+$protoc = "../vcpkg_installed/arm64-android/tools/protobuf/protoc"
+if (-not (Test-Path -Path $protoc)) {
+    $protoc = "protoc"
+}
+
 $out = "./src/proto"
 
 if (Test-Path -Path $out) {
@@ -10,7 +16,7 @@ if (Test-Path -Path $out) {
 }
 New-Item -ItemType Directory -Path $out | Out-Null
 
-& ../vcpkg_installed/arm64-android/tools/protobuf/protoc `
+& $protoc `
     --plugin=protoc-gen-ts_proto=$path `
     --ts_proto_opt=oneof=unions-value --ts_proto_opt=outputJsonMethods=false `
     --ts_proto_out=./src/proto --proto_path=../protos `
@@ -29,8 +29,8 @@ function VideoDownload() {
 
   ON_MESSAGE.addListener((packet) => {
     if (packet.$case === "videoFrame") {
-      const { data } = packet.value;
-      if (data[4] === 103) file.clear();
+      const { data, key } = packet.value;
+      if (key) file.clear();
       file.add(data);
     }
   });
@@ -57,6 +57,30 @@ function VideoDownload() {
   );
 }
 
+// key codes from include/accumulator.hpp: printable keys are their uppercase
+// ascii value, named keys reuse control characters
+const namedKeys: Record<string, number> = {
+  Backspace: 8,
+  Enter: 13,
+  Shift: 16,
+  F2: 17,
+  Delete: 127,
+};
+
+const keyCode = (key: string) => {
+  if (key.length === 1)
+    return key.charCodeAt(0) < 128 ? key.toUpperCase().charCodeAt(0) : 0;
+  return namedKeys[key] ?? 0;
+};
+
+// sets bit code % 32 of word code / 32
+const withKey = (mask: number[] | undefined, code: number) => {
+  const ret = [...(mask ?? [])];
+  while (ret.length <= code >> 5) ret.push(0);
+  ret[code >> 5] = (ret[code >> 5] | (1 << (code & 31))) >>> 0;
+  return ret;
+};
+
 class InputManager {
   loop() {
     if (Object.keys(this.next).length !== 0) {
@@ -91,11 +115,21 @@ class InputManager {
   }
 
   onKeyDown(event: KeyboardEvent) {
-    this.next.keysDown = [...(this.next.keysDown ?? []), event.key];
+    const code = keyCode(event.key);
+    if (code === 0) return;
+    this.next.keysDownMask = withKey(this.next.keysDownMask, code);
+    // the in game keyboard needs every character in order, which masks lose
+    let typed = "";
+    if (event.key.length === 1) typed = event.key;
+    else if (code === namedKeys.Backspace || code === namedKeys.Delete)
+      typed = "\b";
+    else if (code === namedKeys.Enter) typed = "\n";
+    if (typed) this.next.text = (this.next.text ?? "") + typed;
   }
 
   onKeyUp(event: KeyboardEvent) {
-    this.next.keysUp = [...(this.next.keysUp ?? []), event.key];
+    const code = keyCode(event.key);
+    if (code !== 0) this.next.keysUpMask = withKey(this.next.keysUpMask, code);
   }
 
   onWheel(event: WheelEvent) {
@@ -203,7 +237,11 @@ function Stream() {
 
   ON_MESSAGE.addListener((packet) => {
     if (packet.$case === "videoFrame")
-      decoder.postMessage({ type: "data", val: packet.value.data });
+      decoder.postMessage({
+        type: "data",
+        val: packet.value.data,
+        key: packet.value.key,
+      });
     else if (packet.$case === "audioFrame") {
       audioManager.config(
         packet.value.sampleRate,
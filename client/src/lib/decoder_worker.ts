@@ -1,6 +1,5 @@
 let decoderError = false;
-let wroteSps = false;
-let spsPacket: Uint8Array | undefined;
+let gotKey = false;
 let canvas: OffscreenCanvas | undefined;
 let canvasContext: OffscreenCanvasRenderingContext2D | undefined;
 let decoder: VideoDecoder | undefined;
@@ -13,7 +12,19 @@ const baseConfig: VideoDecoderConfig = {
 };
 let supportedConfig: VideoDecoderConfig;
 
-const isKey = (data: Uint8Array) => data[4] === 101 || data[4] === 103;
+// offset of the start code of the first idr slice
+const findIdr = (data: Uint8Array) => {
+  for (let i = 0; i + 3 < data.length; i++) {
+    if (
+      data[i] === 0 &&
+      data[i + 1] === 0 &&
+      data[i + 2] === 1 &&
+      (data[i + 3] & 0x1f) === 5
+    )
+      return i > 0 && data[i - 1] === 0 ? i - 1 : i;
+  }
+  return -1;
+};
 
 const init: VideoDecoderInit = {
   output: (frame) => {
@@ -26,7 +37,7 @@ const init: VideoDecoderInit = {
   },
 };
 
-const frameBuffer: Uint8Array[] = [];
+const frameBuffer: { data: Uint8Array; key: boolean }[] = [];
 
 let targetLatency = 0;
 let currentFps = 0;
@@ -41,17 +52,17 @@ const atLatency = () => {
 const feed = () => {
   if (!atLatency()) return;
   // todo: skip to the next key frame if that frame is also behind the latency
-  const data = frameBuffer.shift()!;
+  const { data, key } = frameBuffer.shift()!;
   const chunk = new EncodedVideoChunk({
     data,
     timestamp: 0,
-    type: isKey(data) ? "key" : "delta",
+    type: key ? "key" : "delta",
   });
   decoder!.decode(chunk);
 };
 
-const queue = (data: Uint8Array) => {
-  frameBuffer.push(data);
+const queue = (data: Uint8Array, key: boolean) => {
+  frameBuffer.push({ data, key });
   feed();
 };
 
@@ -81,8 +92,7 @@ const flush = () => {
   // clear queue
   frameBuffer.length = 0;
   // restart decoder
-  spsPacket = undefined;
-  wroteSps = false;
+  gotKey = false;
   decoder?.reset();
   if (supportedConfig) decoder?.configure(supportedConfig);
 };
@@ -93,7 +103,7 @@ self.onmessage = (event: MessageEvent) => {
     | { type: "params"; val: { width: number; height: number; fps: number } }
     | { type: "latency"; val: number }
     | { type: "flush" }
-    | { type: "data"; val: Uint8Array };
+    | { type: "data"; val: Uint8Array; key: boolean };
 
   switch (data.type) {
     case "context":
@@ -118,7 +128,7 @@ self.onmessage = (event: MessageEvent) => {
     default:
       try {
         if (decoder === undefined || decoderError) return;
-        let array = data.val;
+        const array = data.val;
         if (
           array[0] !== 0 ||
           array[1] !== 0 ||
@@ -126,18 +136,15 @@ self.onmessage = (event: MessageEvent) => {
           array[3] !== 1
         )
           console.warn("invalid header", array);
+        // each packet is a full access unit, with key frames including sps and pps
+        if (!gotKey && !data.key) return;
+        gotKey = true;
         // firefox takes sps as a separate packet, chrome wants it stuck together with a keyframe
-        if (isChrome && array[4] === 103) {
-          spsPacket = new Uint8Array(array);
-          return;
-        }
-        if (spsPacket !== undefined && !wroteSps && array[4] === 101) {
-          console.log("combining sps with normal packet");
-          array = new Uint8Array([...spsPacket!, ...array]);
-          wroteSps = true;
-        }
-        if (!wroteSps && array[4] !== 103) return;
-        queue(array);
+        const idr = isChrome || !data.key ? -1 : findIdr(array);
+        if (idr > 0) {
+          queue(array.subarray(0, idr), true);
+          queue(array.subarray(idr), true);
+        } else queue(array, data.key);
       } catch (error) {
         console.error("decoding error", error);
       }
@@ -23,11 +23,23 @@ export interface Settings {
   micVolume: number;
   micThreshold: number;
   micMix: number;
+  /** only sent by clients, choosing the encoding of audio frames sent to them */
+  audioEncoding: AudioFrame_Encoding;
+  /** only sent by clients, whether to receive Stats packets */
+  stats: boolean;
+  /** starts or stops recording a trace file on the server, left unchanged if unset */
+  trace?: boolean | undefined;
+  /** only sent by clients, whether to receive audio and video together in Bundle packets */
+  bundle: boolean;
 }
 
+/** one complete h264 access unit in annex b format */
 export interface VideoFrame {
   data: Uint8Array;
+  /** monotonic nanoseconds, same clock as AudioFrame.time */
   time: number;
+  /** starts with sps and pps followed by an idr slice */
+  key: boolean;
 }
 
 export interface AudioFrame {
@@ -35,6 +47,20 @@ export interface AudioFrame {
   sampleRate: number;
   data: number[];
   time: number;
+  encoding: AudioFrame_Encoding;
+  encodedData: Uint8Array;
+  /** index of the first sample per channel since audio started, time is derived from it */
+  sample: number;
+}
+
+export enum AudioFrame_Encoding {
+  /** Float - samples in data */
+  Float = 0,
+  /** Int16 - little endian samples in encodedData */
+  Int16 = 1,
+  /** Adpcm - ima adpcm in encodedData, see core/src/encoding.cpp */
+  Adpcm = 2,
+  UNRECOGNIZED = -1,
 }
 
 export interface Input {
@@ -45,6 +71,63 @@ export interface Input {
   scroll: number;
   keysDown: string[];
   keysUp: string[];
+  /** characters for the in game keyboard in order when using the masks, with \b to delete and \n to confirm */
+  text: string;
+  /**
+   * compact alternative to the key strings, bit n % 32 of word n / 32 is key code n from src/accumulator.cpp
+   * in 32 bit words so they fit in javascript numbers, at most 4 words are used
+   */
+  keysDownMask: number[];
+  keysUpMask: number[];
+}
+
+/** sent periodically by clients to report how well they are keeping up */
+export interface Feedback {
+  /** frames received but not yet decoded */
+  decodeQueue: number;
+  /** seconds between receiving and presenting a frame */
+  latency: number;
+  /** total frames skipped by the client */
+  droppedFrames: number;
+}
+
+/** percentiles of the time spent in one stage of the video pipeline, in microseconds */
+export interface StageTimes {
+  p50: number;
+  p90: number;
+  p99: number;
+  max: number;
+}
+
+/** sent about once a second to clients that enable stats in their settings, covering the frames since the last one */
+export interface Stats {
+  /** monotonic nanoseconds, same clock as VideoFrame.time */
+  time: number;
+  /** video frames handed off to the websocket for this connection */
+  frames: number;
+  /** from the start of the newest rendered game frame to encoder output */
+  encode?: StageTimes | undefined;
+  /** from encoder output to queued for sending */
+  assemble?: StageTimes | undefined;
+  /**
+   * from queued to handed off to the websocket for this connection
+   * not including the time until the socket write completes, which is at most the server's 256 KiB write buffer
+   */
+  send?: StageTimes | undefined;
+  /** the same for audio frames, which are handed off ahead of queued video */
+  audioSend?: StageTimes | undefined;
+}
+
+/**
+ * audio and video sent as one message to clients that enable bundles in their settings
+ * frames with nothing to bundle them with are still sent on their own
+ * the field numbers match PacketWrapper, so the server builds it by concatenating serialized packets
+ */
+export interface Bundle {
+  /** the frame that completed the bundle, unset if it was flushed without one */
+  videoFrame?: VideoFrame | undefined;
+  /** all audio since the previous bundle, in order */
+  audioFrames: AudioFrame[];
 }
 
 export interface PacketWrapper {
@@ -53,6 +136,9 @@ export interface PacketWrapper {
     | { $case: "videoFrame"; value: VideoFrame }
     | { $case: "audioFrame"; value: AudioFrame }
     | { $case: "input"; value: Input }
+    | { $case: "feedback"; value: Feedback }
+    | { $case: "stats"; value: Stats }
+    | { $case: "bundle"; value: Bundle }
     | undefined;
 }
 
@@ -70,6 +156,10 @@ function createBaseSettings(): Settings {
     micVolume: 0,
     micThreshold: 0,
     micMix: 0,
+    audioEncoding: 0,
+    stats: false,
+    trace: undefined,
+    bundle: false,
   };
 }
 
@@ -111,6 +201,18 @@ export const Settings: MessageFns<Settings> = {
     if (message.micMix !== 0) {
       writer.uint32(96).uint32(message.micMix);
     }
+    if (message.audioEncoding !== 0) {
+      writer.uint32(104).int32(message.audioEncoding);
+    }
+    if (message.stats !== false) {
+      writer.uint32(112).bool(message.stats);
+    }
+    if (message.trace !== undefined) {
+      writer.uint32(120).bool(message.trace);
+    }
+    if (message.bundle !== false) {
+      writer.uint32(128).bool(message.bundle);
+    }
     return writer;
   },
 
@@ -217,6 +319,38 @@ export const Settings: MessageFns<Settings> = {
           message.micMix = reader.uint32();
           continue;
         }
+        case 13: {
+          if (tag !== 104) {
+            break;
+          }
+
+          message.audioEncoding = reader.int32() as any;
+          continue;
+        }
+        case 14: {
+          if (tag !== 112) {
+            break;
+          }
+
+          message.stats = reader.bool();
+          continue;
+        }
+        case 15: {
+          if (tag !== 120) {
+            break;
+          }
+
+          message.trace = reader.bool();
+          continue;
+        }
+        case 16: {
+          if (tag !== 128) {
+            break;
+          }
+
+          message.bundle = reader.bool();
+          continue;
+        }
       }
       if ((tag & 7) === 4 || tag === 0) {
         break;
@@ -243,12 +377,16 @@ export const Settings: MessageFns<Settings> = {
     message.micVolume = object.micVolume ?? 0;
     message.micThreshold = object.micThreshold ?? 0;
     message.micMix = object.micMix ?? 0;
+    message.audioEncoding = object.audioEncoding ?? 0;
+    message.stats = object.stats ?? false;
+    message.trace = object.trace ?? undefined;
+    message.bundle = object.bundle ?? false;
     return message;
   },
 };
 
 function createBaseVideoFrame(): VideoFrame {
-  return { data: new Uint8Array(0), time: 0 };
+  return { data: new Uint8Array(0), time: 0, key: false };
 }
 
 export const VideoFrame: MessageFns<VideoFrame> = {
@@ -257,7 +395,10 @@ export const VideoFrame: MessageFns<VideoFrame> = {
       writer.uint32(10).bytes(message.data);
     }
     if (message.time !== 0) {
-      writer.uint32(16).uint32(message.time);
+      writer.uint32(16).uint64(message.time);
+    }
+    if (message.key !== false) {
+      writer.uint32(24).bool(message.key);
     }
     return writer;
   },
@@ -282,7 +423,15 @@ export const VideoFrame: MessageFns<VideoFrame> = {
             break;
           }
 
-          message.time = reader.uint32();
+          message.time = longToNumber(reader.uint64());
+          continue;
+        }
+        case 3: {
+          if (tag !== 24) {
+            break;
+          }
+
+          message.key = reader.bool();
           continue;
         }
       }
@@ -301,12 +450,13 @@ export const VideoFrame: MessageFns<VideoFrame> = {
     const message = createBaseVideoFrame();
     message.data = object.data ?? new Uint8Array(0);
     message.time = object.time ?? 0;
+    message.key = object.key ?? false;
     return message;
   },
 };
 
 function createBaseAudioFrame(): AudioFrame {
-  return { channels: 0, sampleRate: 0, data: [], time: 0 };
+  return { channels: 0, sampleRate: 0, data: [], time: 0, encoding: 0, encodedData: new Uint8Array(0), sample: 0 };
 }
 
 export const AudioFrame: MessageFns<AudioFrame> = {
@@ -323,7 +473,16 @@ export const AudioFrame: MessageFns<AudioFrame> = {
     }
     writer.join();
     if (message.time !== 0) {
-      writer.uint32(32).uint32(message.time);
+      writer.uint32(32).uint64(message.time);
+    }
+    if (message.encoding !== 0) {
+      writer.uint32(40).int32(message.encoding);
+    }
+    if (message.encodedData.length !== 0) {
+      writer.uint32(50).bytes(message.encodedData);
+    }
+    if (message.sample !== 0) {
+      writer.uint32(56).uint64(message.sample);
     }
     return writer;
   },
@@ -374,7 +533,31 @@ export const AudioFrame: MessageFns<AudioFrame> = {
             break;
           }
 
-          message.time = reader.uint32();
+          message.time = longToNumber(reader.uint64());
+          continue;
+        }
+        case 5: {
+          if (tag !== 40) {
+            break;
+          }
+
+          message.encoding = reader.int32() as any;
+          continue;
+        }
+        case 6: {
+          if (tag !== 50) {
+            break;
+          }
+
+          message.encodedData = reader.bytes();
+          continue;
+        }
+        case 7: {
+          if (tag !== 56) {
+            break;
+          }
+
+          message.sample = longToNumber(reader.uint64());
           continue;
         }
       }
@@ -395,12 +578,26 @@ export const AudioFrame: MessageFns<AudioFrame> = {
     message.sampleRate = object.sampleRate ?? 0;
     message.data = object.data?.map((e) => e) || [];
     message.time = object.time ?? 0;
+    message.encoding = object.encoding ?? 0;
+    message.encodedData = object.encodedData ?? new Uint8Array(0);
+    message.sample = object.sample ?? 0;
     return message;
   },
 };
 
 function createBaseInput(): Input {
-  return { dx: 0, dy: 0, mouseDown: false, mouseUp: false, scroll: 0, keysDown: [], keysUp: [] };
+  return {
+    dx: 0,
+    dy: 0,
+    mouseDown: false,
+    mouseUp: false,
+    scroll: 0,
+    keysDown: [],
+    keysUp: [],
+    text: "",
+    keysDownMask: [],
+    keysUpMask: [],
+  };
 }
 
 export const Input: MessageFns<Input> = {
@@ -426,6 +623,19 @@ export const Input: MessageFns<Input> = {
     for (const v of message.keysUp) {
       writer.uint32(58).string(v!);
     }
+    if (message.text !== "") {
+      writer.uint32(98).string(message.text);
+    }
+    writer.uint32(106).fork();
+    for (const v of message.keysDownMask) {
+      writer.fixed32(v);
+    }
+    writer.join();
+    writer.uint32(114).fork();
+    for (const v of message.keysUpMask) {
+      writer.fixed32(v);
+    }
+    writer.join();
     return writer;
   },
 
@@ -492,6 +702,50 @@ export const Input: MessageFns<Input> = {
           message.keysUp.push(reader.string());
           continue;
         }
+        case 12: {
+          if (tag !== 98) {
+            break;
+          }
+
+          message.text = reader.string();
+          continue;
+        }
+        case 13: {
+          if (tag === 109) {
+            message.keysDownMask.push(reader.fixed32());
+
+            continue;
+          }
+
+          if (tag === 106) {
+            const end2 = reader.uint32() + reader.pos;
+            while (reader.pos < end2) {
+              message.keysDownMask.push(reader.fixed32());
+            }
+
+            continue;
+          }
+
+          break;
+        }
+        case 14: {
+          if (tag === 117) {
+            message.keysUpMask.push(reader.fixed32());
+
+            continue;
+          }
+
+          if (tag === 114) {
+            const end2 = reader.uint32() + reader.pos;
+            while (reader.pos < end2) {
+              message.keysUpMask.push(reader.fixed32());
+            }
+
+            continue;
+          }
+
+          break;
+        }
       }
       if ((tag & 7) === 4 || tag === 0) {
         break;
@@ -513,6 +767,335 @@ export const Input: MessageFns<Input> = {
     message.scroll = object.scroll ?? 0;
     message.keysDown = object.keysDown?.map((e) => e) || [];
     message.keysUp = object.keysUp?.map((e) => e) || [];
+    message.text = object.text ?? "";
+    message.keysDownMask = object.keysDownMask?.map((e) => e) || [];
+    message.keysUpMask = object.keysUpMask?.map((e) => e) || [];
+    return message;
+  },
+};
+
+function createBaseFeedback(): Feedback {
+  return { decodeQueue: 0, latency: 0, droppedFrames: 0 };
+}
+
+export const Feedback: MessageFns<Feedback> = {
+  encode(message: Feedback, writer: BinaryWriter = new BinaryWriter()): BinaryWriter {
+    if (message.decodeQueue !== 0) {
+      writer.uint32(8).uint32(message.decodeQueue);
+    }
+    if (message.latency !== 0) {
+      writer.uint32(21).float(message.latency);
+    }
+    if (message.droppedFrames !== 0) {
+      writer.uint32(24).uint32(message.droppedFrames);
+    }
+    return writer;
+  },
+
+  decode(input: BinaryReader | Uint8Array, length?: number): Feedback {
+    const reader = input instanceof BinaryReader ? input : new BinaryReader(input);
+    let end = length === undefined ? reader.len : reader.pos + length;
+    const message = createBaseFeedback();
+    while (reader.pos < end) {
+      const tag = reader.uint32();
+      switch (tag >>> 3) {
+        case 1: {
+          if (tag !== 8) {
+            break;
+          }
+
+          message.decodeQueue = reader.uint32();
+          continue;
+        }
+        case 2: {
+          if (tag !== 21) {
+            break;
+          }
+
+          message.latency = reader.float();
+          continue;
+        }
+        case 3: {
+          if (tag !== 24) {
+            break;
+          }
+
+          message.droppedFrames = reader.uint32();
+          continue;
+        }
+      }
+      if ((tag & 7) === 4 || tag === 0) {
+        break;
+      }
+      reader.skip(tag & 7);
+    }
+    return message;
+  },
+
+  create<I extends Exact<DeepPartial<Feedback>, I>>(base?: I): Feedback {
+    return Feedback.fromPartial(base ?? ({} as any));
+  },
+  fromPartial<I extends Exact<DeepPartial<Feedback>, I>>(object: I): Feedback {
+    const message = createBaseFeedback();
+    message.decodeQueue = object.decodeQueue ?? 0;
+    message.latency = object.latency ?? 0;
+    message.droppedFrames = object.droppedFrames ?? 0;
+    return message;
+  },
+};
+
+function createBaseStageTimes(): StageTimes {
+  return { p50: 0, p90: 0, p99: 0, max: 0 };
+}
+
+export const StageTimes: MessageFns<StageTimes> = {
+  encode(message: StageTimes, writer: BinaryWriter = new BinaryWriter()): BinaryWriter {
+    if (message.p50 !== 0) {
+      writer.uint32(8).uint32(message.p50);
+    }
+    if (message.p90 !== 0) {
+      writer.uint32(16).uint32(message.p90);
+    }
+    if (message.p99 !== 0) {
+      writer.uint32(24).uint32(message.p99);
+    }
+    if (message.max !== 0) {
+      writer.uint32(32).uint32(message.max);
+    }
+    return writer;
+  },
+
+  decode(input: BinaryReader | Uint8Array, length?: number): StageTimes {
+    const reader = input instanceof BinaryReader ? input : new BinaryReader(input);
+    let end = length === undefined ? reader.len : reader.pos + length;
+    const message = createBaseStageTimes();
+    while (reader.pos < end) {
+      const tag = reader.uint32();
+      switch (tag >>> 3) {
+        case 1: {
+          if (tag !== 8) {
+            break;
+          }
+
+          message.p50 = reader.uint32();
+          continue;
+        }
+        case 2: {
+          if (tag !== 16) {
+            break;
+          }
+
+          message.p90 = reader.uint32();
+          continue;
+        }
+        case 3: {
+          if (tag !== 24) {
+            break;
+          }
+
+          message.p99 = reader.uint32();
+          continue;
+        }
+        case 4: {
+          if (tag !== 32) {
+            break;
+          }
+
+          message.max = reader.uint32();
+          continue;
+        }
+      }
+      if ((tag & 7) === 4 || tag === 0) {
+        break;
+      }
+      reader.skip(tag & 7);
+    }
+    return message;
+  },
+
+  create<I extends Exact<DeepPartial<StageTimes>, I>>(base?: I): StageTimes {
+    return StageTimes.fromPartial(base ?? ({} as any));
+  },
+  fromPartial<I extends Exact<DeepPartial<StageTimes>, I>>(object: I): StageTimes {
+    const message = createBaseStageTimes();
+    message.p50 = object.p50 ?? 0;
+    message.p90 = object.p90 ?? 0;
+    message.p99 = object.p99 ?? 0;
+    message.max = object.max ?? 0;
+    return message;
+  },
+};
+
+function createBaseStats(): Stats {
+  return { time: 0, frames: 0, encode: undefined, assemble: undefined, send: undefined, audioSend: undefined };
+}
+
+export const Stats: MessageFns<Stats> = {
+  encode(message: Stats, writer: BinaryWriter = new BinaryWriter()): BinaryWriter {
+    if (message.time !== 0) {
+      writer.uint32(8).uint64(message.time);
+    }
+    if (message.frames !== 0) {
+      writer.uint32(16).uint32(message.frames);
+    }
+    if (message.encode !== undefined) {
+      StageTimes.encode(message.encode, writer.uint32(26).fork()).join();
+    }
+    if (message.assemble !== undefined) {
+      StageTimes.encode(message.assemble, writer.uint32(34).fork()).join();
+    }
+    if (message.send !== undefined) {
+      StageTimes.encode(message.send, writer.uint32(42).fork()).join();
+    }
+    if (message.audioSend !== undefined) {
+      StageTimes.encode(message.audioSend, writer.uint32(50).fork()).join();
+    }
+    return writer;
+  },
+
+  decode(input: BinaryReader | Uint8Array, length?: number): Stats {
+    const reader = input instanceof BinaryReader ? input : new BinaryReader(input);
+    let end = length === undefined ? reader.len : reader.pos + length;
+    const message = createBaseStats();
+    while (reader.pos < end) {
+      const tag = reader.uint32();
+      switch (tag >>> 3) {
+        case 1: {
+          if (tag !== 8) {
+            break;
+          }
+
+          message.time = longToNumber(reader.uint64());
+          continue;
+        }
+        case 2: {
+          if (tag !== 16) {
+            break;
+          }
+
+          message.frames = reader.uint32();
+          continue;
+        }
+        case 3: {
+          if (tag !== 26) {
+            break;
+          }
+
+          message.encode = StageTimes.decode(reader, reader.uint32());
+          continue;
+        }
+        case 4: {
+          if (tag !== 34) {
+            break;
+          }
+
+          message.assemble = StageTimes.decode(reader, reader.uint32());
+          continue;
+        }
+        case 5: {
+          if (tag !== 42) {
+            break;
+          }
+
+          message.send = StageTimes.decode(reader, reader.uint32());
+          continue;
+        }
+        case 6: {
+          if (tag !== 50) {
+            break;
+          }
+
+          message.audioSend = StageTimes.decode(reader, reader.uint32());
+          continue;
+        }
+      }
+      if ((tag & 7) === 4 || tag === 0) {
+        break;
+      }
+      reader.skip(tag & 7);
+    }
+    return message;
+  },
+
+  create<I extends Exact<DeepPartial<Stats>, I>>(base?: I): Stats {
+    return Stats.fromPartial(base ?? ({} as any));
+  },
+  fromPartial<I extends Exact<DeepPartial<Stats>, I>>(object: I): Stats {
+    const message = createBaseStats();
+    message.time = object.time ?? 0;
+    message.frames = object.frames ?? 0;
+    message.encode = (object.encode !== undefined && object.encode !== null)
+      ? StageTimes.fromPartial(object.encode)
+      : undefined;
+    message.assemble = (object.assemble !== undefined && object.assemble !== null)
+      ? StageTimes.fromPartial(object.assemble)
+      : undefined;
+    message.send = (object.send !== undefined && object.send !== null)
+      ? StageTimes.fromPartial(object.send)
+      : undefined;
+    message.audioSend = (object.audioSend !== undefined && object.audioSend !== null)
+      ? StageTimes.fromPartial(object.audioSend)
+      : undefined;
+    return message;
+  },
+};
+
+function createBaseBundle(): Bundle {
+  return { videoFrame: undefined, audioFrames: [] };
+}
+
+export const Bundle: MessageFns<Bundle> = {
+  encode(message: Bundle, writer: BinaryWriter = new BinaryWriter()): BinaryWriter {
+    if (message.videoFrame !== undefined) {
+      VideoFrame.encode(message.videoFrame, writer.uint32(18).fork()).join();
+    }
+    for (const v of message.audioFrames) {
+      AudioFrame.encode(v!, writer.uint32(26).fork()).join();
+    }
+    return writer;
+  },
+
+  decode(input: BinaryReader | Uint8Array, length?: number): Bundle {
+    const reader = input instanceof BinaryReader ? input : new BinaryReader(input);
+    let end = length === undefined ? reader.len : reader.pos + length;
+    const message = createBaseBundle();
+    while (reader.pos < end) {
+      const tag = reader.uint32();
+      switch (tag >>> 3) {
+        case 2: {
+          if (tag !== 18) {
+            break;
+          }
+
+          message.videoFrame = VideoFrame.decode(reader, reader.uint32());
+          continue;
+        }
+        case 3: {
+          if (tag !== 26) {
+            break;
+          }
+
+          message.audioFrames.push(AudioFrame.decode(reader, reader.uint32()));
+          continue;
+        }
+      }
+      if ((tag & 7) === 4 || tag === 0) {
+        break;
+      }
+      reader.skip(tag & 7);
+    }
+    return message;
+  },
+
+  create<I extends Exact<DeepPartial<Bundle>, I>>(base?: I): Bundle {
+    return Bundle.fromPartial(base ?? ({} as any));
+  },
+  fromPartial<I extends Exact<DeepPartial<Bundle>, I>>(object: I): Bundle {
+    const message = createBaseBundle();
+    message.videoFrame = (object.videoFrame !== undefined && object.videoFrame !== null)
+      ? VideoFrame.fromPartial(object.videoFrame)
+      : undefined;
+    message.audioFrames = object.audioFrames?.map((e) => AudioFrame.fromPartial(e)) || [];
     return message;
   },
 };
@@ -536,6 +1119,15 @@ export const PacketWrapper: MessageFns<PacketWrapper> = {
       case "input":
         Input.encode(message.Packet.value, writer.uint32(34).fork()).join();
         break;
+      case "feedback":
+        Feedback.encode(message.Packet.value, writer.uint32(42).fork()).join();
+        break;
+      case "stats":
+        Stats.encode(message.Packet.value, writer.uint32(50).fork()).join();
+        break;
+      case "bundle":
+        Bundle.encode(message.Packet.value, writer.uint32(58).fork()).join();
+        break;
     }
     return writer;
   },
@@ -579,6 +1171,30 @@ export const PacketWrapper: MessageFns<PacketWrapper> = {
           message.Packet = { $case: "input", value: Input.decode(reader, reader.uint32()) };
           continue;
         }
+        case 5: {
+          if (tag !== 42) {
+            break;
+          }
+
+          message.Packet = { $case: "feedback", value: Feedback.decode(reader, reader.uint32()) };
+          continue;
+        }
+        case 6: {
+          if (tag !== 50) {
+            break;
+          }
+
+          message.Packet = { $case: "stats", value: Stats.decode(reader, reader.uint32()) };
+          continue;
+        }
+        case 7: {
+          if (tag !== 58) {
+            break;
+          }
+
+          message.Packet = { $case: "bundle", value: Bundle.decode(reader, reader.uint32()) };
+          continue;
+        }
       }
       if ((tag & 7) === 4 || tag === 0) {
         break;
@@ -607,6 +1223,18 @@ export const PacketWrapper: MessageFns<PacketWrapper> = {
       object.Packet?.$case === "input" && object.Packet?.value !== undefined && object.Packet?.value !== null
     ) {
       message.Packet = { $case: "input", value: Input.fromPartial(object.Packet.value) };
+    } else if (
+      object.Packet?.$case === "feedback" && object.Packet?.value !== undefined && object.Packet?.value !== null
+    ) {
+      message.Packet = { $case: "feedback", value: Feedback.fromPartial(object.Packet.value) };
+    } else if (
+      object.Packet?.$case === "stats" && object.Packet?.value !== undefined && object.Packet?.value !== null
+    ) {
+      message.Packet = { $case: "stats", value: Stats.fromPartial(object.Packet.value) };
+    } else if (
+      object.Packet?.$case === "bundle" && object.Packet?.value !== undefined && object.Packet?.value !== null
+    ) {
+      message.Packet = { $case: "bundle", value: Bundle.fromPartial(object.Packet.value) };
     }
     return message;
   },
@@ -625,6 +1253,17 @@ type KeysOfUnion<T> = T extends T ? keyof T : never;
 export type Exact<P, I extends P> = P extends Builtin ? P
   : P & { [K in keyof P]: Exact<P[K], I[K]> } & { [K in Exclude<keyof I, KeysOfUnion<P>>]: never };
 
+function longToNumber(int64: { toString(): string }): number {
+  const num = globalThis.Number(int64.toString());
+  if (num > globalThis.Number.MAX_SAFE_INTEGER) {
+    throw new globalThis.Error("Value is larger than Number.MAX_SAFE_INTEGER");
+  }
+  if (num < globalThis.Number.MIN_SAFE_INTEGER) {
+    throw new globalThis.Error("Value is smaller than Number.MIN_SAFE_INTEGER");
+  }
+  return num;
+}
+
 export interface MessageFns<T> {
   encode(message: T, writer?: BinaryWriter): BinaryWriter;
   decode(input: BinaryReader | Uint8Array, length?: number): T;
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+// heap allocations made by the whole process so far, counted by the operator new in main.cpp
+uint64_t Allocations();
+
+// adds the average allocations per iteration since start as a counter
+inline void ReportAllocations(benchmark::State& state, uint64_t start) {
+    state.counters["allocs"] = benchmark::Counter(Allocations() - start, benchmark::Counter::kAvgIterations);
+}
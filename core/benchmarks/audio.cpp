@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include "inputs.hpp"
+#include "mixing.hpp"
+
+// stand-in for Hollywood::SimpleLimiter, which is only available on the headset
+// same shape per sample: an envelope follower and a gain when it goes over 1
+struct Limiter {
+    float envelope = 0;
+    float release = 0;
+
+    void init(int channels, int sampleRate) { release = std::exp(-1.0f / (0.05f * sampleRate * channels)); }
+    float process(float sample) {
+        float level = std::abs(sample);
+        envelope = level > envelope ? level : envelope * release + level * (1 - release);
+        return envelope > 1 ? sample / envelope : sample;
+    }
+};
+
+// one OnAudioFilterRead call, argument is frames per callback
+static void BM_ScaledInsert(benchmark::State& state) {
+    auto samples = Inputs::Game(state.range(0));
+    RingBuffer<float> buffer(1 << 17);
+    for (auto _ : state) {
+        Mixing::ScaledInsert(buffer, samples.data(), samples.size(), 0.8);
+        // keep the buffer from filling up, which would skip the copy
+        buffer.CommitRead(buffer.Available());
+    }
+    state.SetItemsProcessed(state.iterations() * samples.size());
+    state.SetBytesProcessed(state.iterations() * samples.size() * sizeof(float));
+}
+BENCHMARK(BM_ScaledInsert)->Arg(256)->Arg(512)->Arg(1024);
+
+// the vector kernels against the plain loops in Mixing::Reference, argument is samples per block
+static void BM_Scale(benchmark::State& state, void (*scale)(float*, float const*, size_t, float)) {
+    auto samples = Inputs::Game(state.range(0) / Inputs::Channels);
+    std::vector<float> dest(samples.size());
+    for (auto _ : state) {
+        scale(dest.data(), samples.data(), samples.size(), 0.8);
+        benchmark::DoNotOptimize(dest.data());
+    }
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK_CAPTURE(BM_Scale, vector, Mixing::Scale)->Arg(1066)->Arg(1600);
+BENCHMARK_CAPTURE(BM_Scale, reference, Mixing::Reference::Scale)->Arg(1066)->Arg(1600);
+
+// mixes into the same block every iteration, the values don't matter for the timing
+static void BM_Mix(benchmark::State& state, void (*mix)(float*, float const*, size_t, bool)) {
+    auto game = Inputs::Game(state.range(0) / Inputs::Channels);
+    auto mic = Inputs::Mic(state.range(0) / Inputs::Channels);
+    for (auto _ : state) {
+        mix(game.data(), mic.data(), game.size(), true);
+        benchmark::DoNotOptimize(game.data());
+    }
+    state.SetItemsProcessed(state.iterations() * game.size());
+}
+BENCHMARK_CAPTURE(BM_Mix, combine_vector, Mixing::Mix<Mixing::Mode::Combine>)->Arg(1066)->Arg(1600);
+BENCHMARK_CAPTURE(BM_Mix, combine_reference, Mixing::Reference::Mix<Mixing::Mode::Combine>)->Arg(1066)->Arg(1600);
+BENCHMARK_CAPTURE(BM_Mix, add_vector, Mixing::Mix<Mixing::Mode::Add>)->Arg(1066)->Arg(1600);
+BENCHMARK_CAPTURE(BM_Mix, add_reference, Mixing::Reference::Mix<Mixing::Mode::Add>)->Arg(1066)->Arg(1600);
+
+// AudioCapture::Update with mic data, arguments are the mix mode and frames per update
+static void BM_MixLimit(benchmark::State& state) {
+    auto mode = (Mixing::Mode) state.range(0);
+    size_t size = state.range(1) * Inputs::Channels;
+    RingBuffer<float> gameBuffer(1 << 17);
+    RingBuffer<float> micBuffer(1 << 17);
+    // filled once, reading never changes the contents so they can be made available again without copying
+    auto game = Inputs::Game(gameBuffer.Capacity() / Inputs::Channels);
+    auto mic = Inputs::Mic(micBuffer.Capacity() / Inputs::Channels);
+    Mixing::ScaledInsert(gameBuffer, game.data(), game.size(), 1);
+    Mixing::ScaledInsert(micBuffer, mic.data(), mic.size(), 1);
+    std::vector<float> mixBuffer(size);
+    Limiter limiter;
+    limiter.init(Inputs::Channels, Inputs::SampleRate);
+    for (auto _ : state) {
+        if (gameBuffer.Available() < size) {
+            gameBuffer.CommitWrite(gameBuffer.Free());
+            micBuffer.CommitWrite(micBuffer.Free());
+        }
+        Mixing::Read(gameBuffer, mixBuffer.data(), size);
+        Mixing::MixRead(mode, micBuffer, mixBuffer.data(), size, true);
+        Mixing::Limit(limiter, mixBuffer.data(), size);
+        benchmark::DoNotOptimize(mixBuffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * size);
+}
+// 800, 667 and 533 frames are one update at 60, 72 and 90 fps
+BENCHMARK(BM_MixLimit)->ArgsProduct({{(int) Mixing::Mode::Combine, (int) Mixing::Mode::Duck, (int) Mixing::Mode::Add}, {533, 667, 800}});
+
+// mic loudness check for each mic callback, argument is samples per callback
+static void BM_Loudness(benchmark::State& state) {
+    auto samples = Inputs::Mic(state.range(0) / Inputs::Channels);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(Mixing::Loudness(samples.data(), samples.size()));
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(BM_Loudness)->Arg(512)->Arg(1024)->Arg(2048);
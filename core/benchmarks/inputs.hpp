@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// fixed inputs so results are comparable between runs
+namespace Inputs {
+    static constexpr int SampleRate = 48000;
+    static constexpr int Channels = 2;
+    static constexpr int Fps = 60;
+
+    // interleaved stereo tone with some noise, roughly at game volume
+    inline std::vector<float> Game(size_t frames) {
+        std::vector<float> ret(frames * Channels);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> noise(-0.05, 0.05);
+        for (size_t i = 0; i < frames; i++) {
+            float tone = 0.5f * std::sin(2 * M_PI * 440 * i / SampleRate);
+            for (int c = 0; c < Channels; c++)
+                ret[i * Channels + c] = tone + noise(rng);
+        }
+        return ret;
+    }
+
+    // quieter noise, like speech picked up by the headset mic
+    inline std::vector<float> Mic(size_t frames) {
+        std::vector<float> ret(frames * Channels);
+        std::mt19937 rng(2);
+        std::uniform_real_distribution<float> noise(-0.2, 0.2);
+        for (auto& sample : ret)
+            sample = noise(rng);
+        return ret;
+    }
+
+    // size of an average access unit at the given bitrate, the encoder fills incompressible data
+    inline std::vector<uint8_t> AccessUnit(int kbps) {
+        std::vector<uint8_t> ret(kbps * 1000 / 8 / Fps);
+        std::mt19937 rng(3);
+        for (auto& byte : ret)
+            byte = rng();
+        return ret;
+    }
+}
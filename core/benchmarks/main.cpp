@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocations.hpp"
+#include "log.hpp"
+
+static std::atomic<uint64_t> allocations = 0;
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ret = std::malloc(size))
+        return ret;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+uint64_t Allocations() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+static void Quiet(Log::Level level, std::string const& message) {
+    if (level >= Log::Level::Warn)
+        std::fprintf(stderr, "%s\n", message.c_str());
+}
+
+int main(int argc, char** argv) {
+    // connection logs would end up in the middle of the results
+    Log::SetSink(Quiet);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include "math.hpp"
+
+struct Vector3 {
+    float x, y, z;
+};
+
+struct Quaternion {
+    float x, y, z, w;
+};
+
+// once per frame for the smoothed camera position
+static void BM_EaseLerp(benchmark::State& state) {
+    Vector3 position = {0, 1.7, 0};
+    Vector3 target = {0.05, 1.72, -0.02};
+    float time = 0;
+    for (auto _ : state) {
+        position = EaseLerp(position, target, time, 1 / 72.0f);
+        benchmark::DoNotOptimize(position);
+        time += 1 / 72.0f;
+    }
+}
+BENCHMARK(BM_EaseLerp);
+
+// once per frame for the smoothed camera rotation, close and far apart rotations take different branches
+static void BM_Slerp(benchmark::State& state) {
+    Quaternion rotation = {0, 0, 0, 1};
+    Quaternion target = state.range(0) ? Quaternion{0, 0.7071, 0, 0.7071} : Quaternion{0, 0.0001, 0, 1};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Slerp(rotation, target, 1 / 72.0f));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_Slerp)->Arg(0)->Arg(1);
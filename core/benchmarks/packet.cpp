@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include "allocations.hpp"
+#include "encoding.hpp"
+#include "inputs.hpp"
+#include "packet.hpp"
+#include "pool.hpp"
+#include "stream.pb.h"
+
+// sps and pps sent before each key frame, about this size for the encoder's output
+static constexpr size_t ParameterSetsSize = 32;
+
+// as in onOutputUnit, with the buffer going back to the pool like the sender thread does, argument is the bitrate in kbps
+static void BM_VideoFrame(benchmark::State& state) {
+    auto unit = Inputs::AccessUnit(state.range(0));
+    std::vector<uint8_t> parameterSets(ParameterSetsSize, 0x42);
+    bool key = false;
+    uint64_t allocations = Allocations();
+    for (auto _ : state) {
+        auto serialized = Pool::Acquire(unit.size() + parameterSets.size() + Packet::MaxVideoFrameOverhead);
+        Packet::WriteVideoFrame(serialized, key ? std::span(parameterSets) : std::span<uint8_t const>(), unit, 123456789, key);
+        benchmark::DoNotOptimize(serialized.data());
+        Pool::Release(std::move(serialized));
+        key = !key;
+    }
+    ReportAllocations(state, allocations);
+    state.SetBytesProcessed(state.iterations() * unit.size());
+}
+BENCHMARK(BM_VideoFrame)->Arg(10000)->Arg(20000)->Arg(40000);
+
+// one 10 ms packet as built in SendAudio and serialized by the sender thread, argument is the encoding
+static void BM_AudioFrame(benchmark::State& state) {
+    auto encoding = (AudioFrame::Encoding) state.range(0);
+    auto samples = Inputs::Game(Inputs::SampleRate / 100);
+    std::vector<Encoding::AdpcmState> adpcmState;
+    PacketWrapper packet;
+    uint64_t allocations = Allocations();
+    for (auto _ : state) {
+        Packet::SetAudioFrame(packet, samples, Inputs::SampleRate, Inputs::Channels, 480, 123456789, encoding, adpcmState);
+        auto serialized = Packet::Serialize(packet);
+        benchmark::DoNotOptimize(serialized.data());
+        Pool::Release(std::move(serialized));
+    }
+    ReportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(BM_AudioFrame)->Arg(AudioFrame::Float)->Arg(AudioFrame::Int16)->Arg(AudioFrame::Adpcm);
@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <websocketpp/client.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+
+#include "allocations.hpp"
+#include "inputs.hpp"
+#include "pool.hpp"
+#include "packet.hpp"
+#include "socket.hpp"
+
+using Client = websocketpp::client<websocketpp::config::asio_client>;
+
+static constexpr int Port = 3307;
+static constexpr auto Timeout = std::chrono::seconds(5);
+
+static bool StartServer() {
+    static bool started = [] {
+        Socket::Init({});
+        return Socket::Start(Port);
+    }();
+    return started;
+}
+
+// waits for the condition, false if it took too long
+template <class F>
+static bool WaitFor(F&& condition) {
+    auto deadline = std::chrono::steady_clock::now() + Timeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+// loopback viewers that only count what they receive
+class Viewers {
+    Client client;
+    std::thread thread;
+    std::vector<websocketpp::connection_hdl> connections;
+
+   public:
+    std::atomic<uint64_t> received = 0;
+
+    Viewers(int count) {
+        client.clear_access_channels(websocketpp::log::alevel::all);
+        client.clear_error_channels(websocketpp::log::elevel::all);
+        client.init_asio();
+        client.set_message_handler([this](websocketpp::connection_hdl, Client::message_ptr) { received++; });
+        for (int i = 0; i < count; i++) {
+            websocketpp::lib::error_code ec;
+            auto connection = client.get_connection("ws://127.0.0.1:" + std::to_string(Port), ec);
+            if (ec)
+                continue;
+            connections.emplace_back(connection->get_handle());
+            client.connect(connection);
+        }
+        thread = std::thread([this]() { client.run(); });
+    }
+
+    ~Viewers() {
+        for (auto& connection : connections) {
+            websocketpp::lib::error_code ec;
+            client.close(connection, websocketpp::close::status::going_away, "", ec);
+        }
+        thread.join();
+    }
+};
+
+// sends one packet at a time and waits until every viewer has it, arguments are the packet type and the number of viewers
+static void BM_SocketFanOut(benchmark::State& state) {
+    if (!StartServer()) {
+        state.SkipWithError("server failed to start");
+        return;
+    }
+    bool video = state.range(0);
+    size_t count = state.range(1);
+    std::unique_ptr<Viewers> viewers = std::make_unique<Viewers>(count);
+    if (!WaitFor([count]() { return Socket::GetStats().size() == count; })) {
+        state.SkipWithError("viewers failed to connect");
+        return;
+    }
+
+    auto unit = Inputs::AccessUnit(40000);
+    auto samples = Inputs::Game(Inputs::SampleRate / 100);
+    PacketWrapper audio;
+    audio.mutable_audioframe()->set_channels(Inputs::Channels);
+    audio.mutable_audioframe()->set_samplerate(Inputs::SampleRate);
+    *audio.mutable_audioframe()->mutable_data() = {samples.begin(), samples.end()};
+    size_t bytes = video ? unit.size() : audio.ByteSizeLong();
+
+    uint64_t expected = 0;
+    bool key = true;
+    uint64_t allocations = Allocations();
+    for (auto _ : state) {
+        if (video) {
+            auto serialized = Pool::Acquire(unit.size() + Packet::MaxVideoFrameOverhead);
+            Packet::WriteVideoFrame(serialized, {}, unit, 0, key);
+            Socket::SendVideo(std::move(serialized), key, {});
+            // new connections drop video until the first key frame
+            key = false;
+        } else
+            Socket::Send(audio);
+        expected += count;
+        if (!WaitFor([&viewers, expected]() { return viewers->received >= expected; })) {
+            state.SkipWithError("viewers stopped receiving");
+            break;
+        }
+    }
+    // includes the allocations made by websocketpp and asio on both ends
+    ReportAllocations(state, allocations);
+    state.SetBytesProcessed(state.iterations() * bytes * count);
+
+    viewers.reset();
+    Socket::ClearCachedVideo();
+    WaitFor([]() { return Socket::GetStats().empty(); });
+}
+BENCHMARK(BM_SocketFanOut)->ArgsProduct({{0, 1}, {1, 2, 4, 8}})->UseRealTime();
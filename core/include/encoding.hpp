@@ -0,0 +1,17 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Encoding {
+    struct AdpcmState {
+        int predictor = 0;
+        int index = 0;
+    };
+
+    // little endian 16 bit pcm
+    void Int16(std::span<float const> samples, std::string& out);
+    // 4 bit ima adpcm, continuing from the state of each channel
+    void Adpcm(std::span<float const> samples, int channels, std::vector<AdpcmState>& state, std::string& out);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+
+namespace H264 {
+    enum class NalType : uint8_t { Slice = 1, Idr = 5, Sei = 6, Sps = 7, Pps = 8, Delimiter = 9 };
+
+    struct Nal {
+        // including the start code
+        std::span<uint8_t const> data;
+        NalType type;
+    };
+
+    // calls func with each nal unit in an annex b byte stream
+    template <class F>
+    void ForEachNal(std::span<uint8_t const> stream, F&& func) {
+        size_t start = std::string::npos;
+        auto emit = [&stream, &start, &func](size_t end) {
+            // start points at the nal header, include the preceding start code
+            size_t codeStart = start >= 4 && stream[start - 4] == 0 ? start - 4 : start - 3;
+            func(Nal{stream.subspan(codeStart, end - codeStart), (NalType) (stream[start] & 0x1f)});
+        };
+        for (size_t i = 0; i + 3 < stream.size(); i++) {
+            if (stream[i] != 0 || stream[i + 1] != 0 || stream[i + 2] != 1)
+                continue;
+            if (start != std::string::npos)
+                emit(i > 0 && stream[i - 1] == 0 ? i - 1 : i);
+            start = i + 3;
+            i += 2;
+        }
+        if (start != std::string::npos && start < stream.size())
+            emit(stream.size());
+    }
+
+    struct AccessUnit {
+        // sps and pps to send before the data, if it is a key frame that doesn't include them
+        std::span<uint8_t const> parameterSets;
+        std::span<uint8_t const> data;
+        bool key;
+    };
+
+    // turns encoder output into complete access units, holding back parameter sets until the next idr
+    class Assembler {
+        std::string parameterSets;
+
+       public:
+        std::optional<AccessUnit> Add(std::span<uint8_t const> unit);
+        void Reset() { parameterSets.clear(); }
+    };
+}
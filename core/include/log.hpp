@@ -0,0 +1,36 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <string>
+
+// the core can't use the mod logger, so it logs through a sink that the mod forwards to it
+namespace Log {
+    enum class Level { Debug, Info, Warn, Error };
+
+    using Sink = void (*)(Level level, std::string const& message);
+
+    // stderr until set
+    void SetSink(Sink sink);
+    void Write(Level level, std::string const& message);
+
+    // core sources declare their own, as the mod's logger in main.hpp has the same name
+    struct Logger {
+        template <class... TArgs>
+        void debug(fmt::format_string<TArgs...> format, TArgs&&... args) const {
+            Write(Level::Debug, fmt::format(format, std::forward<TArgs>(args)...));
+        }
+        template <class... TArgs>
+        void info(fmt::format_string<TArgs...> format, TArgs&&... args) const {
+            Write(Level::Info, fmt::format(format, std::forward<TArgs>(args)...));
+        }
+        template <class... TArgs>
+        void warn(fmt::format_string<TArgs...> format, TArgs&&... args) const {
+            Write(Level::Warn, fmt::format(format, std::forward<TArgs>(args)...));
+        }
+        template <class... TArgs>
+        void error(fmt::format_string<TArgs...> format, TArgs&&... args) const {
+            Write(Level::Error, fmt::format(format, std::forward<TArgs>(args)...));
+        }
+    };
+}
@@ -1,7 +1,6 @@
 #pragma once
 
-#include "UnityEngine/Quaternion.hpp"
-#include "UnityEngine/Vector3.hpp"
+#include <cmath>
 
 // all credit to @fern [https://github.com/Fernthedev/]
 
@@ -20,11 +19,15 @@ static float EasedLerp(float from, float to, float time, float deltaTime) {
 }
 
 // This will make it so big movements are actually exponentially bigger while smaller ones are less
-static UnityEngine::Vector3 EaseLerp(UnityEngine::Vector3 a, UnityEngine::Vector3 b, float time, float deltaTime) {
+// works with any vector type with x, y, z members, such as UnityEngine::Vector3
+template <class V>
+static V EaseLerp(V a, V b, float time, float deltaTime) {
     return {EasedLerp(a.x, b.x, time, deltaTime), EasedLerp(a.y, b.y, time, deltaTime), EasedLerp(a.z, b.z, time, deltaTime)};
 }
 
-static UnityEngine::Quaternion Slerp(UnityEngine::Quaternion quaternion1, UnityEngine::Quaternion quaternion2, float amount) {
+// works with any quaternion type with x, y, z, w members, such as UnityEngine::Quaternion
+template <class Q>
+static Q Slerp(Q quaternion1, Q quaternion2, float amount) {
     float num = quaternion1.x * quaternion2.x + quaternion1.y * quaternion2.y + quaternion1.z * quaternion2.z + quaternion1.w * quaternion2.w;
     bool flag = false;
     if (num < 0) {
@@ -42,7 +45,7 @@ static UnityEngine::Quaternion Slerp(UnityEngine::Quaternion quaternion1, UnityE
         num2 = std::sin((1.0f - amount) * num4) * num5;
         num3 = (flag ? (-std::sin(amount * num4) * num5) : (std::sin(amount * num4) * num5));
     }
-    UnityEngine::Quaternion result;
+    Q result;
     result.x = num2 * quaternion1.x + num3 * quaternion2.x;
     result.y = num2 * quaternion1.y + num3 * quaternion2.y;
     result.z = num2 * quaternion1.z + num3 * quaternion2.z;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <string_view>
+
+// lock free metrics that can be updated from any thread and scraped over http
+namespace Metrics {
+    class Counter {
+        std::atomic<uint64_t> value = 0;
+
+       public:
+        void Add(uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+        uint64_t Get() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    class Gauge {
+        std::atomic<double> value = 0;
+
+       public:
+        void Set(double set) { value.store(set, std::memory_order_relaxed); }
+        double Get() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    // durations in nanoseconds, with buckets doubling from 50 microseconds to about 1.6 seconds
+    class Histogram {
+       public:
+        static constexpr size_t Buckets = 16;
+        static constexpr uint64_t FirstBound = 50'000;
+
+        void Observe(uint64_t nanos);
+        void Write(std::string& out, std::string_view name, std::string_view help) const;
+
+       private:
+        // the last bucket is for everything above the largest bound
+        std::array<std::atomic<uint64_t>, Buckets + 1> counts = {};
+        std::atomic<uint64_t> sum = 0;
+    };
+
+    inline Counter EncoderRestarts;
+    // packet buffers and websocket messages that had to be allocated because none could be reused
+    inline Counter BufferAllocations;
+    // time between scheduling work for the main thread and it running
+    inline Histogram DispatchLag;
+    inline Histogram UpdateTime;
+    // time packets waited in the queue of a connection before being handed off to websocketpp, by the priority they are sent with
+    inline Histogram ControlQueueDelay;
+    inline Histogram AudioQueueDelay;
+    inline Histogram VideoQueueDelay;
+    // fraction of the audio ring buffers filled before each read
+    inline Gauge GameBufferFill;
+    inline Gauge MicBufferFill;
+
+    // everything in the prometheus text format, including per connection stats from the socket
+    std::string Serialize();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "ringbuffer.hpp"
+
+namespace Mixing {
+    // same order as Config::MixModeStrings
+    enum class Mode { Combine, Duck, Add };
+
+    // dest[i] = src[i] * gain, dest and src may be the same
+    inline void Scale(float* dest, float const* src, size_t count, float gain) {
+        size_t i = 0;
+#if defined(__ARM_NEON)
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(dest + i, vmulq_n_f32(vld1q_f32(src + i), gain));
+#elif defined(__SSE__)
+        __m128 factor = _mm_set1_ps(gain);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_loadu_ps(src + i), factor));
+#endif
+        for (; i < count; i++)
+            dest[i] = src[i] * gain;
+    }
+
+    // game[i] = game[i] + mic[i], scaled by the given factor
+    inline void Sum(float* game, float const* mic, size_t count, float factor) {
+        size_t i = 0;
+#if defined(__ARM_NEON)
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(game + i, vmulq_n_f32(vaddq_f32(vld1q_f32(game + i), vld1q_f32(mic + i)), factor));
+#elif defined(__SSE__)
+        __m128 scale = _mm_set1_ps(factor);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(game + i, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(game + i), _mm_loadu_ps(mic + i)), scale));
+#endif
+        for (; i < count; i++)
+            game[i] = (game[i] + mic[i]) * factor;
+    }
+
+    // plain per sample loops, the vector kernels must match these
+    // only used to check and benchmark them against
+    namespace Reference {
+        inline void Scale(float* dest, float const* src, size_t count, float gain) {
+            for (size_t i = 0; i < count; i++)
+                dest[i] = src[i] * gain;
+        }
+
+        // same as the per sample mixing before it was done in blocks
+        template <Mode M>
+        inline void Mix(float* game, float const* mic, size_t count, bool hasMicData) {
+            for (size_t i = 0; i < count; i++) {
+                if constexpr (M == Mode::Add)
+                    game[i] += mic[i];
+                else if (M == Mode::Combine || hasMicData)
+                    game[i] = (game[i] + mic[i]) / 2;
+            }
+        }
+    }
+
+    // mixes a block of mic samples into the game samples in place
+    template <Mode M>
+    inline void Mix(float* game, float const* mic, size_t count, bool hasMicData) {
+        if constexpr (M == Mode::Add)
+            Sum(game, mic, count, 1);
+        else if (M == Mode::Combine || hasMicData)
+            Sum(game, mic, count, 0.5);
+    }
+
+    // applies a per sample limiter over a whole block
+    template <class L>
+    inline void Limit(L& limiter, float* samples, size_t count) {
+        for (size_t i = 0; i < count; i++)
+            samples[i] = limiter.process(samples[i]);
+    }
+
+    // root mean square - maybe use some sort of weighting filter in the future?
+    // https://community.vcvrack.com/t/complete-list-of-native-fft-libraries-for-audio/9153
+    inline float Loudness(float const* samples, size_t count) {
+        if (count == 0)
+            return 0;
+        float sum = 0;
+        for (size_t i = 0; i < count; i++)
+            sum += samples[i] * samples[i];
+        return std::sqrt(sum / count);
+    }
+
+    // never locks or allocates, samples that don't fit are dropped
+    inline void ScaledInsert(RingBuffer<float>& buffer, float const* src, size_t count, float volume) {
+        size_t written = 0;
+        for (auto region : buffer.PrepareWrite(count)) {
+            Scale(region.data(), src + written, region.size(), volume);
+            written += region.size();
+        }
+        buffer.CommitWrite(written);
+    }
+
+    inline void Read(RingBuffer<float>& buffer, float* dest, size_t count) {
+        for (auto region : buffer.PrepareRead(count))
+            dest = std::copy(region.begin(), region.end(), dest);
+        buffer.CommitRead(count);
+    }
+
+    template <Mode M>
+    inline void MixRead(RingBuffer<float>& buffer, float* game, size_t count, bool hasMicData) {
+        for (auto region : buffer.PrepareRead(count)) {
+            Mix<M>(game, region.data(), region.size(), hasMicData);
+            game += region.size();
+        }
+        buffer.CommitRead(count);
+    }
+
+    // reads count mic samples and mixes them into game, picking the loop for the mode once per block
+    inline void MixRead(Mode mode, RingBuffer<float>& buffer, float* game, size_t count, bool hasMicData) {
+        switch (mode) {
+            case Mode::Combine:
+                MixRead<Mode::Combine>(buffer, game, count, hasMicData);
+                break;
+            case Mode::Duck:
+                MixRead<Mode::Duck>(buffer, game, count, hasMicData);
+                break;
+            default:
+                MixRead<Mode::Add>(buffer, game, count, hasMicData);
+                break;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "encoding.hpp"
+#include "stream.pb.h"
+
+namespace Packet {
+    // more than the bytes WriteVideoFrame adds around the data
+    static constexpr size_t MaxVideoFrameOverhead = 32;
+    // more than the bytes WriteBundle adds around the packets
+    static constexpr size_t MaxBundleOverhead = 16;
+
+    // appends a serialized PacketWrapper containing a VideoFrame, copying the data only once
+    void WriteVideoFrame(std::string& out, std::span<uint8_t const> prefix, std::span<uint8_t const> data, uint64_t time, bool key);
+    // appends a serialized PacketWrapper containing a Bundle, made from serialized PacketWrappers that each hold an AudioFrame
+    // except for at most one VideoFrame
+    void WriteBundle(std::string& out, std::span<std::string const* const> packets);
+    // serializes into a buffer from the pool
+    std::string Serialize(PacketWrapper const& packet);
+
+    // makes packet an AudioFrame with the samples in the given encoding, adpcm continuing from state
+    // reusing the same packet keeps the capacity of its sample buffers
+    void SetAudioFrame(
+        PacketWrapper& packet,
+        std::span<float const> samples,
+        int sampleRate,
+        int channels,
+        uint64_t sample,
+        uint64_t time,
+        AudioFrame::Encoding encoding,
+        std::vector<Encoding::AdpcmState>& state
+    );
+
+    // splits audio into fixed length packets, timestamped by their position in the stream
+    class AudioSplitter {
+        std::vector<float> packet;
+        int sampleRate = -1;
+        int channels = -1;
+        uint64_t samples = 0;
+        uint64_t startTime = 0;
+
+       public:
+        using Send = std::function<void(std::span<float const> packet, int sampleRate, int channels, uint64_t sample, uint64_t time)>;
+
+        // now is the monotonic time the samples were received, send is called for each complete packet
+        void Add(std::span<float const> samples, int sampleRate, int channels, int packetMs, uint64_t now, Send const& send);
+        void Reset() { sampleRate = -1; }
+    };
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// recycles serialization buffers between the threads building packets and the sender thread, keeping their capacity
+namespace Pool {
+    // an empty buffer with at least this capacity, only allocating if no free buffer is big enough
+    std::string Acquire(size_t capacity);
+    // keeps the buffer for reuse if there is room, otherwise frees it
+    void Release(std::string&& buffer);
+}
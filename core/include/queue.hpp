@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+
+// unbounded multi producer single consumer queue, pushing is a single atomic exchange
+// popped nodes are kept for reuse without locks, so a steady stream of pushes doesn't allocate
+// https://www.1024cores.net/home/lock-free-algorithms/queues/non-intrusive-mpsc-node-based-queue
+template <class T>
+class MpscQueue {
+    struct Node {
+        std::atomic<Node*> next = nullptr;
+        std::optional<T> value;
+    };
+
+    // nodes a producer thread took from the free list, usable with any queue of the same type
+    struct Cache {
+        Node* nodes = nullptr;
+        ~Cache() {
+            while (auto node = nodes) {
+                nodes = node->next.load(std::memory_order_relaxed);
+                delete node;
+            }
+        }
+    };
+
+    // about how many nodes are kept, the count is only approximate
+    static constexpr size_t MaxFreeNodes = 256;
+
+    static inline thread_local Cache cache;
+
+    alignas(64) std::atomic<Node*> head;
+    alignas(64) Node* tail;
+    // only the consumer pushes here and producers only ever take the whole list, so there is no aba problem
+    alignas(64) std::atomic<Node*> freeNodes = nullptr;
+    std::atomic<size_t> freeCount = 0;
+
+    Node* NewNode() {
+        if (!cache.nodes && freeNodes.load(std::memory_order_relaxed)) {
+            cache.nodes = freeNodes.exchange(nullptr, std::memory_order_acquire);
+            freeCount.store(0, std::memory_order_relaxed);
+        }
+        if (auto node = cache.nodes) {
+            cache.nodes = node->next.load(std::memory_order_relaxed);
+            node->next.store(nullptr, std::memory_order_relaxed);
+            return node;
+        }
+        return new Node();
+    }
+
+    // consumer only
+    void FreeNode(Node* node) {
+        if (freeCount.load(std::memory_order_relaxed) >= MaxFreeNodes) {
+            delete node;
+            return;
+        }
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+        auto top = freeNodes.load(std::memory_order_relaxed);
+        do
+            node->next.store(top, std::memory_order_relaxed);
+        while (!freeNodes.compare_exchange_weak(top, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+   public:
+    MpscQueue() { head = tail = new Node(); }
+    ~MpscQueue() {
+        while (Pop())
+            ;
+        delete tail;
+        auto node = freeNodes.load(std::memory_order_acquire);
+        while (node) {
+            auto next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+    MpscQueue(MpscQueue const&) = delete;
+    MpscQueue& operator=(MpscQueue const&) = delete;
+
+    void Push(T value) {
+        auto node = NewNode();
+        node->value.emplace(std::move(value));
+        auto prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // only safe to call from the consumer thread
+    std::optional<T> Pop() {
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+            return std::nullopt;
+        std::optional<T> ret = std::move(next->value);
+        next->value.reset();
+        FreeNode(tail);
+        tail = next;
+        return ret;
+    }
+};
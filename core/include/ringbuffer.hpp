@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+
+// wait-free single producer single consumer ring buffer with a fixed capacity
+template <class T>
+class RingBuffer {
+    std::unique_ptr<T[]> data;
+    size_t capacity;
+
+    // positions only ever increase, the index into data is position & (capacity - 1)
+    alignas(64) std::atomic<size_t> writePos = 0;
+    alignas(64) std::atomic<size_t> readPos = 0;
+
+    template <class U>
+    std::array<std::span<U>, 2> Regions(U* base, size_t pos, size_t count) const {
+        size_t start = pos & (capacity - 1);
+        size_t first = std::min(count, capacity - start);
+        return {std::span<U>(base + start, first), std::span<U>(base, count - first)};
+    }
+
+   public:
+    RingBuffer(size_t minCapacity) : data(new T[std::bit_ceil(minCapacity)]()), capacity(std::bit_ceil(minCapacity)) {}
+    RingBuffer(RingBuffer const&) = delete;
+    RingBuffer& operator=(RingBuffer const&) = delete;
+
+    size_t Capacity() const { return capacity; }
+
+    // producer side
+    size_t Free() const { return capacity - (writePos.load(std::memory_order_relaxed) - readPos.load(std::memory_order_acquire)); }
+    // up to count slots to fill, split where the buffer wraps around
+    std::array<std::span<T>, 2> PrepareWrite(size_t count) {
+        return Regions(data.get(), writePos.load(std::memory_order_relaxed), std::min(count, Free()));
+    }
+    void CommitWrite(size_t count) { writePos.store(writePos.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+
+    // consumer side
+    size_t Available() const { return writePos.load(std::memory_order_acquire) - readPos.load(std::memory_order_relaxed); }
+    std::array<std::span<T const>, 2> PrepareRead(size_t count) const {
+        return Regions<T const>(data.get(), readPos.load(std::memory_order_relaxed), std::min(count, Available()));
+    }
+    void CommitRead(size_t count) { readPos.store(readPos.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+    void Clear() { readPos.store(writePos.load(std::memory_order_acquire), std::memory_order_release); }
+};
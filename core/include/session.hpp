@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+
+// records the inputs of a session to a binary file, so it can be replayed without the game
+namespace Session {
+    enum class Kind : uint8_t {
+        // once per AudioCapture::Update, with the settings it used
+        Update = 0,
+        // raw samples from OnAudioFilterRead and the volume applied to them
+        GameAudio = 1,
+        MicAudio = 2,
+        // encoder output before assembling access units
+        VideoUnit = 3,
+        // serialized PacketWrapper received from a connection
+        Message = 4,
+    };
+
+    struct Update {
+        int32_t sampleRate;
+        int32_t channels;
+        int32_t mixMode;
+        int32_t audioPacketLength;
+    };
+
+    struct Entry {
+        Kind kind;
+        // monotonic nanoseconds when it was recorded
+        uint64_t time;
+        std::string data;
+    };
+
+    inline std::atomic_bool recording = false;
+
+    // where session files are written, the working directory by default
+    void SetDirectory(std::string directory);
+    void Start();
+    // stops recording, the rest of the file is written in the background
+    void Stop();
+    // copies the data and returns, the file is written on another thread
+    void Record(Kind kind, uint64_t time, std::span<uint8_t const> data);
+    // doesn't lock or allocate once warmed up, so it can be called on the audio threads
+    // dropped if the writer thread falls too far behind
+    void RecordAudio(Kind kind, uint64_t time, float volume, std::span<float const> samples);
+    void RecordUpdate(uint64_t time, Update const& update);
+
+    class Reader {
+        std::ifstream file;
+
+       public:
+        bool Open(std::string const& path);
+        std::optional<Entry> Next();
+    };
+
+    // for GameAudio and MicAudio entries
+    float AudioVolume(Entry const& entry);
+    std::span<float const> AudioSamples(Entry const& entry);
+    // for Update entries, empty if the entry is truncated or has no audio format
+    std::optional<Update> GetUpdate(Entry const& entry);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <span>
+
+#include "stream.pb.h"
+
+namespace Socket {
+    struct ConnectionStats {
+        void* id;
+        size_t queuedFrames;
+        size_t queuedBytes;
+        size_t bufferedBytes;
+        uint64_t sentFrames;
+        // fewer than the frames if the connection receives bundles
+        uint64_t sentMessages;
+        uint64_t sentBytes;
+        uint64_t droppedFrames;
+        uint32_t decodeQueue;
+        float latency;
+    };
+
+    // time spent by producers handing packets to the sender thread
+    struct SenderStats {
+        uint64_t pushedPackets;
+        uint64_t blockedNanos;
+        uint64_t maxBlockedNanos;
+    };
+
+    // monotonic nanoseconds at each stage a video frame has passed before being sent
+    struct FrameTimes {
+        uint64_t capture;
+        uint64_t encoded;
+    };
+
+    // all called on the network thread, so they should hand off any slow work
+    struct Handlers {
+        std::function<void(void* connection)> open;
+        // after the last connection closes
+        std::function<void()> empty;
+        std::function<void(PacketWrapper packet, void* source)> message;
+        // input is split from other messages so it can be applied without a task for each packet
+        std::function<void(Input const& input)> input;
+    };
+
+    void Init(Handlers handlers);
+    bool Start(int port);
+    // closes all connections, IsRunning turns false once the server thread has exited
+    void Stop();
+    bool IsRunning();
+    bool HasConnections();
+    void Send(PacketWrapper packet, void* exclude = nullptr);
+    // takes a serialized PacketWrapper with a VideoFrame
+    void SendVideo(std::string&& serialized, bool key, FrameTimes times);
+    void SendTo(PacketWrapper packet, void* target);
+    // takes a serialized PacketWrapper with an AudioFrame, only sent to connections that requested the encoding
+    void SendAudio(std::string&& serialized, AudioFrame::Encoding encoding);
+    // encodes one packet of samples once for each encoding used by current connections, matching Packet::AudioSplitter::Send
+    // only call from one thread, since the adpcm state carries over between packets
+    void SendAudioSamples(std::span<float const> samples, int sampleRate, int channels, uint64_t sample, uint64_t time);
+    // bitmask of the audio encodings used by current connections
+    uint32_t GetAudioEncodings();
+    // whether there is video starting from a key frame to send to new connections
+    bool HasCachedVideo();
+    // the cache can be cleared before the sender thread gets to the replay, in which case missed is called on that thread
+    void SendCachedVideo(void* target, std::function<void()> missed);
+    // call when the encoder restarts, as the cached video can't be decoded with its new output
+    void ClearCachedVideo();
+    std::vector<ConnectionStats> GetStats();
+    SenderStats GetSenderStats();
+}
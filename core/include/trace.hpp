@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// scoped timing events, written to a chrome trace json file that can be opened in perfetto
+namespace Trace {
+    inline std::atomic_bool enabled = false;
+
+    // where trace files are written, the working directory by default
+    void SetDirectory(std::string directory);
+    void Start();
+    // stops recording and writes the file in the background
+    void Stop();
+    uint64_t Now();
+    // lock free, each thread writes to its own buffer
+    void Record(char const* name, uint64_t start, uint64_t end);
+
+    class Scope {
+        char const* name;
+        uint64_t start = 0;
+
+       public:
+        Scope(char const* name) : name(name) {
+            if (enabled.load(std::memory_order_relaxed))
+                start = Now();
+        }
+        ~Scope() {
+            if (start)
+                Record(name, start, Now());
+        }
+    };
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// name must be a string literal
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
@@ -0,0 +1,86 @@
+#include "encoding.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+static constexpr int IndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static constexpr int StepTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,    31,    34,    37,
+    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,   130,   143,   157,   173,   190,   209,
+    230,   253,   279,   307,   337,   371,   408,   449,   494,   544,   598,   658,   724,   796,   876,   963,   1060,  1166,
+    1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,
+    7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static inline int16_t ToInt16(float sample) {
+    return (int16_t) std::lrint(std::clamp(sample, -1.0f, 1.0f) * 32767);
+}
+
+static inline uint8_t EncodeSample(Encoding::AdpcmState& state, int sample) {
+    int step = StepTable[state.index];
+    int diff = sample - state.predictor;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    // same as the decoder: delta = (2 * magnitude + 1) * step / 8
+    int delta = step >> 3;
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+        delta += step;
+    }
+    if (diff >= step >> 1) {
+        nibble |= 2;
+        diff -= step >> 1;
+        delta += step >> 1;
+    }
+    if (diff >= step >> 2) {
+        nibble |= 1;
+        delta += step >> 2;
+    }
+    state.predictor = std::clamp(state.predictor + (nibble & 8 ? -delta : delta), -32768, 32767);
+    state.index = std::clamp(state.index + IndexTable[nibble], 0, 88);
+    return nibble;
+}
+
+void Encoding::Int16(std::span<float const> samples, std::string& out) {
+    size_t start = out.size();
+    out.resize(start + samples.size() * sizeof(int16_t));
+    auto dest = (uint8_t*) out.data() + start;
+    for (float sample : samples) {
+        auto value = (uint16_t) ToInt16(sample);
+        *dest++ = value & 0xff;
+        *dest++ = value >> 8;
+    }
+}
+
+void Encoding::Adpcm(std::span<float const> samples, int channels, std::vector<AdpcmState>& state, std::string& out) {
+    if (channels <= 0)
+        return;
+    state.resize(channels);
+
+    // header of the starting state for each channel: predictor (int16 le), step index (uint8), padding (uint8)
+    size_t start = out.size();
+    out.resize(start + channels * 4 + (samples.size() + 1) / 2);
+    auto dest = (uint8_t*) out.data() + start;
+    for (auto const& channel : state) {
+        auto predictor = (uint16_t) channel.predictor;
+        *dest++ = predictor & 0xff;
+        *dest++ = predictor >> 8;
+        *dest++ = channel.index;
+        *dest++ = 0;
+    }
+
+    // interleaved samples, two per byte with the first in the low bits
+    for (size_t i = 0; i < samples.size(); i++) {
+        uint8_t nibble = EncodeSample(state[i % channels], ToInt16(samples[i]));
+        if (i % 2 == 0)
+            *dest = nibble;
+        else
+            *dest++ |= nibble << 4;
+    }
+}
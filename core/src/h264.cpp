@@ -0,0 +1,40 @@
+#include "h264.hpp"
+
+using namespace H264;
+
+std::optional<AccessUnit> Assembler::Add(std::span<uint8_t const> unit) {
+    bool hasParameters = false;
+    bool hasSlice = false;
+    bool hasIdr = false;
+    size_t firstSlice = unit.size();
+
+    ForEachNal(unit, [&](Nal const& nal) {
+        switch (nal.type) {
+            case NalType::Sps:
+            case NalType::Pps:
+                hasParameters = true;
+                break;
+            case NalType::Idr:
+                hasIdr = true;
+                [[fallthrough]];
+            case NalType::Slice:
+                if (!hasSlice)
+                    firstSlice = nal.data.data() - unit.data();
+                hasSlice = true;
+                break;
+            default:
+                break;
+        }
+    });
+
+    // codec config output, or parameter sets in front of the slices
+    if (hasParameters)
+        parameterSets.assign((char const*) unit.data(), firstSlice);
+    if (!hasSlice)
+        return std::nullopt;
+
+    AccessUnit ret = {.data = unit, .key = hasIdr};
+    if (hasIdr && !hasParameters)
+        ret.parameterSets = {(uint8_t const*) parameterSets.data(), parameterSets.size()};
+    return ret;
+}
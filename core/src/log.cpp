@@ -0,0 +1,19 @@
+#include "log.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+static void StderrSink(Log::Level level, std::string const& message) {
+    static constexpr char const* Names[] = {"debug", "info", "warn", "error"};
+    std::fprintf(stderr, "[%s] %s\n", Names[(int) level], message.c_str());
+}
+
+static std::atomic<Log::Sink> sink = StderrSink;
+
+void Log::SetSink(Sink set) {
+    sink = set ? set : StderrSink;
+}
+
+void Log::Write(Level level, std::string const& message) {
+    sink.load()(level, message);
+}
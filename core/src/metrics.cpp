@@ -0,0 +1,89 @@
+#include "metrics.hpp"
+
+#include <fmt/format.h>
+
+#include "socket.hpp"
+
+using namespace Metrics;
+
+static void WriteHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+    out += fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+template <class T>
+static void WriteValue(std::string& out, std::string_view name, std::string_view type, std::string_view help, T value) {
+    WriteHeader(out, name, type, help);
+    out += fmt::format("{} {}\n", name, value);
+}
+
+template <class F>
+static void WriteConnections(
+    std::string& out, std::vector<Socket::ConnectionStats> const& stats, std::string_view name, std::string_view type, std::string_view help, F get
+) {
+    WriteHeader(out, name, type, help);
+    for (auto const& connection : stats)
+        out += fmt::format("{}{{connection=\"{}\"}} {}\n", name, connection.id, get(connection));
+}
+
+void Histogram::Observe(uint64_t nanos) {
+    size_t bucket = 0;
+    for (uint64_t bound = FirstBound; bucket < Buckets && nanos > bound; bound *= 2)
+        bucket++;
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+void Histogram::Write(std::string& out, std::string_view name, std::string_view help) const {
+    WriteHeader(out, name, "histogram", help);
+    uint64_t total = 0;
+    uint64_t bound = FirstBound;
+    for (size_t i = 0; i < Buckets; i++, bound *= 2) {
+        total += counts[i].load(std::memory_order_relaxed);
+        out += fmt::format("{}_bucket{{le=\"{}\"}} {}\n", name, bound / 1e9, total);
+    }
+    total += counts[Buckets].load(std::memory_order_relaxed);
+    out += fmt::format("{}_bucket{{le=\"+Inf\"}} {}\n", name, total);
+    out += fmt::format("{}_sum {}\n", name, sum.load(std::memory_order_relaxed) / 1e9);
+    out += fmt::format("{}_count {}\n", name, total);
+}
+
+std::string Metrics::Serialize() {
+    std::string out;
+
+    auto connections = Socket::GetStats();
+    WriteValue(out, "stream_connections", "gauge", "Connected viewers", connections.size());
+    WriteConnections(out, connections, "stream_sent_bytes_total", "counter", "Bytes handed off to websocketpp for each connection", [](auto& stats) {
+        return stats.sentBytes;
+    });
+    WriteConnections(out, connections, "stream_sent_frames_total", "counter", "Packets handed off to websocketpp for each connection", [](auto& stats) {
+        return stats.sentFrames;
+    });
+    WriteConnections(out, connections, "stream_sent_messages_total", "counter", "Websocket messages handed off to websocketpp for each connection", [](auto& stats) {
+        return stats.sentMessages;
+    });
+    WriteConnections(out, connections, "stream_dropped_frames_total", "counter", "Video frames dropped for each connection", [](auto& stats) {
+        return stats.droppedFrames;
+    });
+    WriteConnections(out, connections, "stream_queued_bytes", "gauge", "Bytes waiting in the send queue of each connection", [](auto& stats) {
+        return stats.queuedBytes;
+    });
+    WriteConnections(out, connections, "stream_buffered_bytes", "gauge", "Bytes waiting in the socket buffer of each connection", [](auto& stats) {
+        return stats.bufferedBytes;
+    });
+
+    auto sender = Socket::GetSenderStats();
+    WriteValue(out, "stream_pushed_packets_total", "counter", "Packets handed to the sender thread", sender.pushedPackets);
+    WriteValue(out, "stream_push_blocked_seconds_total", "counter", "Time spent handing packets to the sender thread", sender.blockedNanos / 1e9);
+
+    WriteValue(out, "stream_encoder_restarts_total", "counter", "Times the encoder was restarted", EncoderRestarts.Get());
+    WriteValue(out, "stream_buffer_allocations_total", "counter", "Packet buffers and messages allocated instead of reused", BufferAllocations.Get());
+    WriteValue(out, "stream_game_buffer_fill", "gauge", "Fraction of the game audio buffer filled", GameBufferFill.Get());
+    WriteValue(out, "stream_mic_buffer_fill", "gauge", "Fraction of the microphone audio buffer filled", MicBufferFill.Get());
+    DispatchLag.Write(out, "stream_dispatch_lag_seconds", "Time between scheduling work for the main thread and it running");
+    UpdateTime.Write(out, "stream_update_seconds", "Time spent in the streaming manager each frame");
+    ControlQueueDelay.Write(out, "stream_control_queue_delay_seconds", "Time settings and stats waited in connection queues");
+    AudioQueueDelay.Write(out, "stream_audio_queue_delay_seconds", "Time audio frames waited in connection queues");
+    VideoQueueDelay.Write(out, "stream_video_queue_delay_seconds", "Time video frames waited in connection queues");
+
+    return out;
+}
@@ -0,0 +1,141 @@
+#include "packet.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "log.hpp"
+#include "pool.hpp"
+#include "stream.pb.h"
+
+static constexpr Log::Logger logger{};
+
+// re-anchor audio timestamps if the sample count drifts this far from the clock, such as after dropped samples
+static constexpr int64_t MaxAudioDrift = 200'000'000;
+
+using CodedOutputStream = google::protobuf::io::CodedOutputStream;
+
+enum WireType : uint32_t { Varint = 0, Length = 2 };
+
+static constexpr uint32_t Tag(int field, WireType type) {
+    return (field << 3) | type;
+}
+
+static void AppendVarint(std::string& out, uint64_t value) {
+    uint8_t buffer[10];
+    auto end = CodedOutputStream::WriteVarint64ToArray(value, buffer);
+    out.append((char*) buffer, end - buffer);
+}
+
+void Packet::WriteVideoFrame(std::string& out, std::span<uint8_t const> prefix, std::span<uint8_t const> data, uint64_t time, bool key) {
+    constexpr uint32_t dataTag = Tag(VideoFrame::kDataFieldNumber, Length);
+    constexpr uint32_t timeTag = Tag(VideoFrame::kTimeFieldNumber, Varint);
+    constexpr uint32_t keyTag = Tag(VideoFrame::kKeyFieldNumber, Varint);
+    constexpr uint32_t frameTag = Tag(PacketWrapper::kVideoFrameFieldNumber, Length);
+
+    size_t length = prefix.size() + data.size();
+    size_t frameSize = CodedOutputStream::VarintSize32(dataTag) + CodedOutputStream::VarintSize64(length) + length;
+    if (time != 0)
+        frameSize += CodedOutputStream::VarintSize32(timeTag) + CodedOutputStream::VarintSize64(time);
+    if (key)
+        frameSize += CodedOutputStream::VarintSize32(keyTag) + 1;
+
+    out.reserve(out.size() + CodedOutputStream::VarintSize32(frameTag) + CodedOutputStream::VarintSize64(frameSize) + frameSize);
+    AppendVarint(out, frameTag);
+    AppendVarint(out, frameSize);
+    AppendVarint(out, dataTag);
+    AppendVarint(out, length);
+    out.append((char const*) prefix.data(), prefix.size());
+    out.append((char const*) data.data(), data.size());
+    if (time != 0) {
+        AppendVarint(out, timeTag);
+        AppendVarint(out, time);
+    }
+    if (key) {
+        AppendVarint(out, keyTag);
+        AppendVarint(out, 1);
+    }
+}
+
+void Packet::WriteBundle(std::string& out, std::span<std::string const* const> packets) {
+    static_assert((int) Bundle::kVideoFrameFieldNumber == (int) PacketWrapper::kVideoFrameFieldNumber);
+    static_assert((int) Bundle::kAudioFramesFieldNumber == (int) PacketWrapper::kAudioFrameFieldNumber);
+    constexpr uint32_t bundleTag = Tag(PacketWrapper::kBundleFieldNumber, Length);
+
+    size_t bundleSize = 0;
+    for (auto packet : packets)
+        bundleSize += packet->size();
+
+    out.reserve(out.size() + CodedOutputStream::VarintSize32(bundleTag) + CodedOutputStream::VarintSize64(bundleSize) + bundleSize);
+    AppendVarint(out, bundleTag);
+    AppendVarint(out, bundleSize);
+    for (auto packet : packets)
+        out.append(*packet);
+}
+
+std::string Packet::Serialize(PacketWrapper const& packet) {
+    auto ret = Pool::Acquire(packet.ByteSizeLong());
+    packet.SerializeToString(&ret);
+    return ret;
+}
+
+void Packet::SetAudioFrame(
+    PacketWrapper& packet,
+    std::span<float const> samples,
+    int sampleRate,
+    int channels,
+    uint64_t sample,
+    uint64_t time,
+    AudioFrame::Encoding encoding,
+    std::vector<Encoding::AdpcmState>& state
+) {
+    auto& audio = *packet.mutable_audioframe();
+    audio.set_channels(channels);
+    audio.set_samplerate(sampleRate);
+    audio.set_time(time);
+    audio.set_sample(sample);
+    audio.set_encoding(encoding);
+    // clearing keeps the allocated space
+    audio.mutable_data()->Clear();
+    audio.mutable_encodeddata()->clear();
+    if (encoding == AudioFrame::Float)
+        audio.mutable_data()->Add(samples.begin(), samples.end());
+    else if (encoding == AudioFrame::Int16)
+        Encoding::Int16(samples, *audio.mutable_encodeddata());
+    else
+        Encoding::Adpcm(samples, channels, state, *audio.mutable_encodeddata());
+}
+
+static inline uint64_t SamplesToNanos(uint64_t samples, int sampleRate) {
+    return samples * 1'000'000'000 / sampleRate;
+}
+
+void Packet::AudioSplitter::Add(std::span<float const> added, int rate, int channelCount, int packetMs, uint64_t now, Send const& send) {
+    if (rate != sampleRate || channelCount != channels) {
+        packet.clear();
+        sampleRate = rate;
+        channels = channelCount;
+        samples = 0;
+        startTime = now;
+    }
+    size_t packetSize = std::max(sampleRate * packetMs / 1000, 1) * channels;
+    packet.reserve(packetSize);
+
+    uint64_t received = samples + (packet.size() + added.size()) / channels;
+    int64_t drift = (int64_t) (now - startTime) - (int64_t) SamplesToNanos(received, sampleRate);
+    if (std::abs(drift) > MaxAudioDrift) {
+        logger.debug("re-anchoring audio time after drift of {} ms", drift / 1'000'000);
+        startTime += drift;
+    }
+
+    while (!added.empty()) {
+        size_t take = std::min(added.size(), packetSize - std::min(packetSize, packet.size()));
+        packet.insert(packet.end(), added.begin(), added.begin() + take);
+        added = added.subspan(take);
+        if (packet.size() < packetSize)
+            break;
+        send(packet, sampleRate, channels, samples, startTime + SamplesToNanos(samples, sampleRate));
+        samples += packet.size() / channels;
+        packet.clear();
+    }
+}
@@ -0,0 +1,59 @@
+#include "pool.hpp"
+
+#include <mutex>
+#include <vector>
+
+#include "metrics.hpp"
+
+// enough for the packets in flight between producers and the sender thread
+static constexpr size_t MaxFree = 32;
+
+static std::mutex mutex;
+static std::vector<std::string> freeBuffers = []() {
+    std::vector<std::string> ret;
+    ret.reserve(MaxFree);
+    return ret;
+}();
+
+std::string Pool::Acquire(size_t capacity) {
+    std::string ret;
+    {
+        std::unique_lock lock(mutex);
+        // the smallest one that fits, so large ones stay free for key frames, otherwise the largest to grow
+        auto best = freeBuffers.end();
+        for (auto it = freeBuffers.begin(); it != freeBuffers.end(); it++) {
+            if (best == freeBuffers.end()) {
+                best = it;
+                continue;
+            }
+            bool fits = it->capacity() >= capacity;
+            bool bestFits = best->capacity() >= capacity;
+            if (fits != bestFits ? fits : (fits ? it->capacity() < best->capacity() : it->capacity() > best->capacity()))
+                best = it;
+        }
+        if (best != freeBuffers.end()) {
+            std::swap(*best, freeBuffers.back());
+            ret = std::move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+    if (ret.capacity() < capacity) {
+        Metrics::BufferAllocations.Add();
+        ret.reserve(capacity);
+    }
+    return ret;
+}
+
+void Pool::Release(std::string&& buffer) {
+    // not worth keeping if it never left the small string storage
+    if (buffer.capacity() <= std::string().capacity())
+        return;
+    buffer.clear();
+    // freed after unlocking if there is no room
+    std::string dropped;
+    std::unique_lock lock(mutex);
+    if (freeBuffers.size() < MaxFree)
+        freeBuffers.push_back(std::move(buffer));
+    else
+        dropped = std::move(buffer);
+}
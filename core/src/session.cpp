@@ -0,0 +1,200 @@
+#include "session.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+
+#include "log.hpp"
+#include "queue.hpp"
+
+static constexpr Log::Logger logger{};
+
+// file layout: Magic, then for each entry the kind (1 byte), time (8 bytes), size (4 bytes) and data, all little endian
+static constexpr char Magic[4] = {'B', 'S', 'S', '1'};
+static constexpr size_t HeaderSize = 1 + 8 + 4;
+// how often the writer thread checks for new entries
+static constexpr auto WriteInterval = std::chrono::milliseconds(20);
+// buffers for audio entries, about two seconds of game and mic audio waiting to be written
+static constexpr size_t PooledBuffers = 512;
+
+// audio entries are recorded on the audio threads, so their buffers are reused instead of allocated
+// and handed out without a lock, the writer thread gives them back once written
+struct PooledBuffer {
+    std::atomic_bool used = false;
+    std::string data;
+};
+
+struct Queued {
+    Session::Entry entry;
+    // where the data goes back to once written, if it came from the pool
+    PooledBuffer* pooled;
+};
+
+static MpscQueue<Queued> entries;
+static std::array<PooledBuffer, PooledBuffers> pooledBuffers;
+static std::atomic<size_t> nextBuffer = 0;
+static std::atomic<uint64_t> droppedEntries = 0;
+static std::string sessionDirectory = ".";
+// recording can't start again until the previous file is written
+static std::atomic_bool writing = false;
+
+static void Write(uint64_t start) {
+    auto directory = std::filesystem::path(sessionDirectory);
+    auto path = directory / ("session_" + std::to_string(start / 1'000'000) + ".bin");
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        logger.error("failed to open session file {}", path.string());
+    file.write(Magic, sizeof(Magic));
+
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    char header[HeaderSize];
+    while (true) {
+        bool stopped = !Session::recording;
+        while (auto queued = entries.Pop()) {
+            auto& entry = queued->entry;
+            // left over from before this recording started
+            if (entry.time >= start) {
+                uint32_t size = entry.data.size();
+                header[0] = (char) entry.kind;
+                std::memcpy(header + 1, &entry.time, 8);
+                std::memcpy(header + 9, &size, 4);
+                file.write(header, HeaderSize);
+                file.write(entry.data.data(), size);
+                count++;
+                bytes += HeaderSize + size;
+            }
+            if (queued->pooled) {
+                queued->pooled->data = std::move(entry.data);
+                queued->pooled->used.store(false, std::memory_order_release);
+            }
+        }
+        if (stopped)
+            break;
+        std::this_thread::sleep_for(WriteInterval);
+    }
+
+    logger.info("wrote {} session entries ({} bytes) to {}", count, bytes, path.string());
+    if (uint64_t dropped = droppedEntries.exchange(0))
+        logger.warn("dropped {} audio entries because writing the session fell behind", dropped);
+    writing = false;
+}
+
+// a buffer no queued entry is using, or null if they all are
+static PooledBuffer* AcquireBuffer() {
+    size_t start = nextBuffer.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < PooledBuffers; i++) {
+        auto& pooled = pooledBuffers[(start + i) % PooledBuffers];
+        if (!pooled.used.load(std::memory_order_relaxed) && !pooled.used.exchange(true, std::memory_order_acquire))
+            return &pooled;
+    }
+    return nullptr;
+}
+
+static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Session::SetDirectory(std::string directory) {
+    sessionDirectory = std::move(directory);
+}
+
+void Session::Start() {
+    if (recording)
+        return;
+    if (writing.exchange(true)) {
+        logger.warn("not starting session recording while the previous one is being written");
+        return;
+    }
+    logger.info("starting session recording");
+    recording = true;
+    std::thread(Write, Now()).detach();
+}
+
+void Session::Stop() {
+    recording = false;
+}
+
+void Session::Record(Kind kind, uint64_t time, std::span<uint8_t const> data) {
+    if (!recording)
+        return;
+    entries.Push({.entry = {.kind = kind, .time = time, .data = std::string((char const*) data.data(), data.size())}, .pooled = nullptr});
+}
+
+void Session::RecordAudio(Kind kind, uint64_t time, float volume, std::span<float const> samples) {
+    if (!recording)
+        return;
+    auto pooled = AcquireBuffer();
+    if (!pooled) {
+        droppedEntries++;
+        return;
+    }
+    // only allocates until the buffer has grown to the callback size
+    auto& data = pooled->data;
+    data.resize(sizeof(float) + samples.size_bytes());
+    std::memcpy(data.data(), &volume, sizeof(float));
+    std::memcpy(data.data() + sizeof(float), samples.data(), samples.size_bytes());
+    entries.Push({.entry = {.kind = kind, .time = time, .data = std::move(data)}, .pooled = pooled});
+}
+
+void Session::RecordUpdate(uint64_t time, Update const& update) {
+    Record(Kind::Update, time, {(uint8_t const*) &update, sizeof(Update)});
+}
+
+bool Session::Reader::Open(std::string const& path) {
+    file.open(path, std::ios::binary);
+    char magic[sizeof(Magic)];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, Magic, sizeof(Magic)) != 0) {
+        logger.error("{} is not a session file", path);
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+std::optional<Session::Entry> Session::Reader::Next() {
+    char header[HeaderSize];
+    if (!file.read(header, HeaderSize))
+        return std::nullopt;
+    Entry ret;
+    uint32_t size;
+    ret.kind = (Kind) header[0];
+    std::memcpy(&ret.time, header + 1, 8);
+    std::memcpy(&size, header + 9, 4);
+    ret.data.resize(size);
+    if (!file.read(ret.data.data(), size)) {
+        logger.warn("session file ends in the middle of an entry");
+        return std::nullopt;
+    }
+    return ret;
+}
+
+float Session::AudioVolume(Entry const& entry) {
+    float ret = 0;
+    if (entry.data.size() >= sizeof(float))
+        std::memcpy(&ret, entry.data.data(), sizeof(float));
+    return ret;
+}
+
+std::span<float const> Session::AudioSamples(Entry const& entry) {
+    if (entry.data.size() < sizeof(float))
+        return {};
+    return {(float const*) (entry.data.data() + sizeof(float)), (entry.data.size() - sizeof(float)) / sizeof(float)};
+}
+
+std::optional<Session::Update> Session::GetUpdate(Entry const& entry) {
+    if (entry.data.size() < sizeof(Update))
+        return std::nullopt;
+    Update ret;
+    std::memcpy(&ret, entry.data.data(), sizeof(Update));
+    // the audio splitter divides by both
+    if (ret.sampleRate <= 0 || ret.channels <= 0)
+        return std::nullopt;
+    return ret;
+}
@@ -0,0 +1,833 @@
+#include "socket.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <semaphore>
+#include <shared_mutex>
+#include <thread>
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+
+#include "log.hpp"
+#include "metrics.hpp"
+#include "packet.hpp"
+#include "pool.hpp"
+#include "queue.hpp"
+#include "session.hpp"
+#include "trace.hpp"
+
+using namespace websocketpp;
+
+static constexpr Log::Logger logger{};
+
+using Message = server<config::asio>::message_ptr;
+
+// only hand data to websocketpp while its own write buffer for the connection is below this
+static constexpr size_t MaxBufferedBytes = 256 * 1024;
+// once a connection has this much queued, video frames are dropped until the next key frame
+static constexpr size_t MaxQueuedBytes = 4 * 1024 * 1024;
+// connections that stay congested for this long are disconnected
+static constexpr auto SlowTimeout = std::chrono::seconds(10);
+// how often the sender thread retries writing queued data when nothing new arrives
+static constexpr auto PumpInterval = std::chrono::milliseconds(5);
+// the video since the last key frame is kept for new connections, unless it gets larger than this
+// well below MaxQueuedBytes, so a replay is never cut off partway by the congestion check
+static constexpr size_t MaxCachedVideoBytes = MaxQueuedBytes / 2;
+// messages kept for reuse, more than are usually queued or cached at once
+static constexpr size_t MaxPooledMessages = 512;
+// audio is held back for a bundle until the next video frame, but not longer than this
+static constexpr auto MaxBundleDelay = std::chrono::milliseconds(20);
+// how often connections that asked for them are sent stage timing summaries
+static constexpr auto StatsInterval = std::chrono::seconds(1);
+
+// each connection writes from the first of these queues that has anything, so settings and audio never wait behind video
+enum class Priority { Control, Audio, Video };
+static constexpr size_t Priorities = 3;
+
+// how long packets of each priority wait in the queue of a connection
+static std::array<Metrics::Histogram*, Priorities> const queueDelays = {
+    &Metrics::ControlQueueDelay,
+    &Metrics::AudioQueueDelay,
+    &Metrics::VideoQueueDelay,
+};
+
+struct Outgoing {
+    Message message;
+    Priority priority;
+    bool video;
+    bool key;
+    // only sent to connections using this audio encoding if set
+    int encoding;
+    // when it was handed to the sender
+    uint64_t queued;
+    // when it was added to the queue of a connection
+    uint64_t enqueued;
+};
+
+enum class Command { Send, ReplayVideo, ClearVideo };
+
+struct Pending {
+    Command command;
+    PacketWrapper packet;
+    std::string serialized;
+    PacketWrapper::PacketCase type;
+    bool key;
+    int encoding;
+    void* exclude;
+    void* target;
+    Socket::FrameTimes times;
+    uint64_t queued;
+    // for replays, if there was nothing cached by the time it was handled
+    std::function<void()> missed;
+};
+
+struct Prepared {
+    Outgoing outgoing;
+    // cached video to send instead, for new connections
+    std::vector<Outgoing> replay;
+    void* exclude;
+    void* target;
+};
+
+// vector with a read position, so a steady stream of frames doesn't allocate like the blocks of a deque
+class OutgoingQueue {
+    std::vector<Outgoing> items;
+    size_t head = 0;
+
+   public:
+    bool Empty() const { return head == items.size(); }
+    size_t Size() const { return items.size() - head; }
+    Outgoing& Front() { return items[head]; }
+    Outgoing& operator[](size_t index) { return items[head + index]; }
+    void Push(Outgoing outgoing) {
+        // only moves what is left to the start when that frees up most of the space
+        if (head > 0 && head >= items.size() / 2) {
+            items.erase(items.begin(), items.begin() + head);
+            head = 0;
+        }
+        items.emplace_back(std::move(outgoing));
+    }
+    void Pop() {
+        // release the message now so it can be reused
+        items[head++] = {};
+        if (head == items.size())
+            Clear();
+    }
+    void Clear() {
+        items.clear();
+        head = 0;
+    }
+    template <class F>
+    void EraseIf(F&& func) {
+        items.erase(std::remove_if(items.begin() + head, items.end(), func), items.end());
+    }
+};
+
+struct Connection {
+    AudioFrame::Encoding encoding = AudioFrame::Float;
+    std::array<OutgoingQueue, Priorities> queues;
+    size_t queuedBytes = 0;
+    // new connections wait for a key frame before receiving any video
+    bool waitingForKey = true;
+    // whether audio and video are sent together as Bundle packets
+    bool bundle = false;
+    std::optional<std::chrono::steady_clock::time_point> congestedSince;
+    uint64_t sentFrames = 0;
+    uint64_t sentMessages = 0;
+    uint64_t sentBytes = 0;
+    uint64_t droppedFrames = 0;
+    // last values reported by the client, if it sends feedback
+    uint32_t decodeQueue = 0;
+    float latency = 0;
+    bool stats = false;
+    // microseconds from queued to handed off for each video and audio frame since the last stats
+    std::vector<uint32_t> sendTimes;
+    std::vector<uint32_t> audioSendTimes;
+};
+
+static bool initialized = false;
+static Socket::Handlers handlers;
+static server<config::asio> socketServer;
+static std::shared_mutex connectionsMutex;
+static std::map<connection_hdl, Connection, std::owner_less<connection_hdl>> connections;
+static std::atomic<uint32_t> audioEncodings = 0;
+static std::atomic_bool threadRunning = false;
+
+// producers only push here, the sender thread does all serialization and writing
+static MpscQueue<Pending> pending;
+// messages are reused once they have been written to every connection and left the video cache, sender thread only
+static std::vector<Message> messagePool;
+static size_t messageCursor = 0;
+
+// bundles built in one pass of the sender thread, so connections bundling the same frames share a message
+struct Bundled {
+    std::vector<void const*> parts;
+    Message message;
+};
+static std::vector<Bundled> bundles;
+static size_t bundleCount = 0;
+static std::vector<std::string const*> bundlePayloads;
+static std::atomic_bool signaled = false;
+static std::binary_semaphore pendingSignal(0);
+static std::atomic<uint64_t> pushedPackets = 0;
+static std::atomic<uint64_t> blockedNanos = 0;
+static std::atomic<uint64_t> maxBlockedNanos = 0;
+
+// only used by the sender thread
+static std::vector<Outgoing> videoCache;
+static size_t videoCacheBytes = 0;
+static std::atomic_bool hasCachedVideo = false;
+static std::vector<uint32_t> encodeTimes;
+static std::vector<uint32_t> assembleTimes;
+
+// monotonic, same clock as the manager's timestamps
+static inline uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline uint32_t Micros(uint64_t from, uint64_t to) {
+    return to > from ? (to - from) / 1000 : 0;
+}
+
+static void Summarize(std::vector<uint32_t>& times, StageTimes& out) {
+    if (times.empty())
+        return;
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](float fraction) {
+        return times[std::min(times.size() - 1, (size_t) (fraction * times.size()))];
+    };
+    out.set_p50(percentile(0.5));
+    out.set_p90(percentile(0.9));
+    out.set_p99(percentile(0.99));
+    out.set_max(times.back());
+}
+
+static OutgoingQueue& Queue(Connection& connection, Priority priority) {
+    return connection.queues[(size_t) priority];
+}
+
+static void DropVideo(Connection& connection) {
+    Queue(connection, Priority::Video).EraseIf([&connection](Outgoing const& outgoing) {
+        connection.queuedBytes -= outgoing.message->get_payload().size();
+        connection.droppedFrames++;
+        return true;
+    });
+}
+
+static void Enqueue(void* id, Connection& connection, Outgoing outgoing) {
+    if (outgoing.video) {
+        bool full = connection.queuedBytes + outgoing.message->get_payload().size() > MaxQueuedBytes;
+        if (connection.waitingForKey && !outgoing.key) {
+            connection.droppedFrames++;
+            return;
+        }
+        if (full && outgoing.key)
+            DropVideo(connection);  // everything queued is outdated by this frame anyway
+        else if (full) {
+            if (!connection.congestedSince) {
+                logger.warn("connection {} is congested, dropping video until the next key frame", id);
+                connection.congestedSince = std::chrono::steady_clock::now();
+            }
+            connection.waitingForKey = true;
+            connection.droppedFrames++;
+            return;
+        }
+        connection.waitingForKey = false;
+    }
+    connection.queuedBytes += outgoing.message->get_payload().size();
+    outgoing.enqueued = Now();
+    Queue(connection, outgoing.priority).Push(std::move(outgoing));
+}
+
+// a message nothing else holds anymore, or a new one if they are all still queued or being written
+static Message AcquireMessage() {
+    for (size_t i = 0; i < messagePool.size(); i++) {
+        auto& message = messagePool[(messageCursor + i) % messagePool.size()];
+        if (message.use_count() == 1) {
+            // pairs with the release when websocketpp dropped its reference on another thread
+            std::atomic_thread_fence(std::memory_order_acquire);
+            messageCursor = (messageCursor + i + 1) % messagePool.size();
+            return message;
+        }
+    }
+    Metrics::BufferAllocations.Add();
+    auto ret = std::make_shared<config::asio::message_type>(nullptr, frame::opcode::value::BINARY, 0);
+    if (messagePool.size() < MaxPooledMessages)
+        messagePool.push_back(ret);
+    return ret;
+}
+
+static Outgoing Prepare(Pending& next) {
+    if (next.serialized.empty()) {
+        next.serialized = Packet::Serialize(next.packet);
+        next.key = next.packet.videoframe().key();
+    }
+    // build a single prepared frame that every connection can write as is, since server frames are never masked
+    Outgoing ret;
+    ret.message = AcquireMessage();
+    // swap so the payload from the message's last use goes back to the pool
+    std::swap(ret.message->get_raw_payload(), next.serialized);
+    Pool::Release(std::move(next.serialized));
+    size_t size = ret.message->get_payload().size();
+    frame::basic_header header(frame::opcode::value::BINARY, size, true, false);
+    ret.message->set_header(frame::prepare_header(header, frame::extended_header(size)));
+    ret.message->set_prepared(true);
+    ret.video = next.type == PacketWrapper::kVideoFrame;
+    if (ret.video)
+        ret.priority = Priority::Video;
+    else if (next.type == PacketWrapper::kAudioFrame)
+        ret.priority = Priority::Audio;
+    else
+        ret.priority = Priority::Control;
+    ret.key = ret.video && next.key;
+    ret.encoding = next.encoding;
+    ret.queued = next.queued;
+    return ret;
+}
+
+// a message with the given number of audio frames from the front of the queue and the next video frame, if any
+// shared with other connections bundling the same frames in this pass
+static Message Bundle(Connection& connection, size_t audioCount, bool withVideo) {
+    auto& audio = Queue(connection, Priority::Audio);
+    auto& video = Queue(connection, Priority::Video);
+    auto part = [&](size_t index) -> Outgoing& { return index < audioCount ? audio[index] : video.Front(); };
+    size_t count = audioCount + withVideo;
+    for (size_t i = 0; i < bundleCount; i++) {
+        auto& parts = bundles[i].parts;
+        if (parts.size() != count)
+            continue;
+        size_t same = 0;
+        while (same < count && parts[same] == part(same).message.get())
+            same++;
+        if (same == count)
+            return bundles[i].message;
+    }
+    if (bundleCount == bundles.size())
+        bundles.emplace_back();
+    auto& bundled = bundles[bundleCount++];
+    bundled.parts.clear();
+    bundlePayloads.clear();
+    size_t size = 0;
+    for (size_t i = 0; i < count; i++) {
+        bundled.parts.push_back(part(i).message.get());
+        bundlePayloads.push_back(&part(i).message->get_payload());
+        size += part(i).message->get_payload().size();
+    }
+    Pending next = {.command = Command::Send, .type = PacketWrapper::kBundle, .encoding = -1};
+    next.serialized = Pool::Acquire(size + Packet::MaxBundleOverhead);
+    Packet::WriteBundle(next.serialized, bundlePayloads);
+    bundled.message = Prepare(next).message;
+    return bundled.message;
+}
+
+// lets the bundles from the last pass be reused once their connections are done with them
+static void ClearBundles() {
+    for (size_t i = 0; i < bundleCount; i++)
+        bundles[i].message.reset();
+    bundleCount = 0;
+}
+
+// removes the front of a queue after it was handed off to websocketpp
+// websocketpp writes it to the socket later, so the times don't include waiting in its buffer, up to MaxBufferedBytes
+static void HandedOff(Connection& connection, Priority priority) {
+    auto& queue = Queue(connection, priority);
+    auto& sent = queue.Front();
+    size_t size = sent.message->get_payload().size();
+    uint64_t now = Now();
+    queueDelays[(size_t) priority]->Observe(now - sent.enqueued);
+    if (priority == Priority::Video)
+        connection.sendTimes.push_back(Micros(sent.queued, now));
+    else if (priority == Priority::Audio)
+        connection.audioSendTimes.push_back(Micros(sent.queued, now));
+    connection.queuedBytes -= size;
+    connection.sentBytes += size;
+    connection.sentFrames++;
+    queue.Pop();
+}
+
+static void ClearQueues(Connection& connection) {
+    for (auto& queue : connection.queues)
+        queue.Clear();
+    connection.queuedBytes = 0;
+}
+
+// returns false if the connection has been congested for too long
+static bool Pump(connection_hdl const& hdl, Connection& connection) {
+    auto con = socketServer.get_con_from_hdl(hdl);
+    auto& audio = Queue(connection, Priority::Audio);
+    auto& video = Queue(connection, Priority::Video);
+    while (con->get_buffered_amount() < MaxBufferedBytes) {
+        // frames that websocketpp already has can't be overtaken, but anything still queued here can
+        auto found = std::find_if(connection.queues.begin(), connection.queues.end(), [](auto& queue) { return !queue.Empty(); });
+        if (found == connection.queues.end())
+            break;
+        auto priority = (Priority) (found - connection.queues.begin());
+        Message message = found->Front().message;
+        size_t audioCount = 0;
+        bool withVideo = false;
+        if (connection.bundle && priority == Priority::Audio) {
+            // audio waits for the next video frame to go out with, but not for long
+            audioCount = audio.Size();
+            withVideo = !video.Empty();
+            if (!withVideo && std::chrono::nanoseconds(Now() - audio.Front().enqueued) < MaxBundleDelay)
+                break;
+            if (audioCount + withVideo > 1)
+                message = Bundle(connection, audioCount, withVideo);
+        }
+        if (auto ec = con->send(message)) {
+            logger.error("send failed: {}", ec.message());
+            ClearQueues(connection);
+            break;
+        }
+        connection.sentMessages++;
+        if (audioCount == 0)
+            HandedOff(connection, priority);
+        for (size_t i = 0; i < audioCount; i++)
+            HandedOff(connection, Priority::Audio);
+        if (withVideo)
+            HandedOff(connection, Priority::Video);
+    }
+    bool empty = std::all_of(connection.queues.begin(), connection.queues.end(), [](auto& queue) { return queue.Empty(); });
+    if (empty)
+        connection.congestedSince = std::nullopt;
+    else if (connection.congestedSince && std::chrono::steady_clock::now() - *connection.congestedSince > SlowTimeout)
+        return false;
+    return true;
+}
+
+static void ClearVideoCache() {
+    videoCache.clear();
+    videoCacheBytes = 0;
+    hasCachedVideo = false;
+}
+
+static void CacheVideo(Outgoing const& outgoing) {
+    if (outgoing.key)
+        ClearVideoCache();
+    else if (videoCache.empty())
+        return;
+    videoCache.emplace_back(outgoing);
+    videoCacheBytes += outgoing.message->get_payload().size();
+    if (videoCacheBytes > MaxCachedVideoBytes) {
+        logger.debug("video since last key frame is too large to cache");
+        ClearVideoCache();
+    }
+    hasCachedVideo = !videoCache.empty();
+}
+
+static void Distribute(void* id, Connection& connection, Prepared const& prepared) {
+    if (id == prepared.exclude || (prepared.target && id != prepared.target))
+        return;
+    if (!prepared.replay.empty()) {
+        // a connection that already got a live key frame would see the same frames twice
+        if (!connection.waitingForKey)
+            return;
+        for (auto const& outgoing : prepared.replay)
+            Enqueue(id, connection, outgoing);
+    } else if (prepared.outgoing.encoding == -1 || prepared.outgoing.encoding == connection.encoding)
+        Enqueue(id, connection, prepared.outgoing);
+}
+
+static Outgoing PrepareStats(Stats const& shared, Connection& connection) {
+    Pending next = {.command = Command::Send, .type = PacketWrapper::kStats, .encoding = -1};
+    auto& stats = *next.packet.mutable_stats();
+    stats = shared;
+    stats.set_frames(connection.sendTimes.size());
+    Summarize(connection.sendTimes, *stats.mutable_send());
+    Summarize(connection.audioSendTimes, *stats.mutable_audiosend());
+    return Prepare(next);
+}
+
+static void SenderThread() {
+    std::vector<Prepared> prepared;
+    std::vector<connection_hdl> slow;
+    auto lastStats = std::chrono::steady_clock::now();
+    while (true) {
+        if (pendingSignal.try_acquire_for(PumpInterval))
+            signaled = false;
+
+        while (auto next = pending.Pop()) {
+            // handle the cache here so it stays in order with the packets around it
+            if (next->command == Command::ClearVideo)
+                ClearVideoCache();
+            else if (next->command == Command::ReplayVideo) {
+                if (!videoCache.empty())
+                    prepared.push_back({.replay = videoCache, .exclude = nullptr, .target = next->target});
+                else if (next->missed)
+                    next->missed();
+            } else {
+                auto outgoing = Prepare(*next);
+                if (outgoing.video) {
+                    CacheVideo(outgoing);
+                    encodeTimes.push_back(Micros(next->times.capture, next->times.encoded));
+                    assembleTimes.push_back(Micros(next->times.encoded, next->queued));
+                }
+                prepared.push_back({.outgoing = std::move(outgoing), .exclude = next->exclude, .target = next->target});
+            }
+        }
+
+        std::optional<Stats> stats;
+        if (auto now = std::chrono::steady_clock::now(); now - lastStats >= StatsInterval) {
+            lastStats = now;
+            stats.emplace();
+            stats->set_time(Now());
+            Summarize(encodeTimes, *stats->mutable_encode());
+            Summarize(assembleTimes, *stats->mutable_assemble());
+            encodeTimes.clear();
+            assembleTimes.clear();
+        }
+
+        {
+            TRACE_SCOPE("Socket::Pump");
+            std::unique_lock lock(connectionsMutex);
+            for (auto& [hdl, connection] : connections) {
+                void* id = hdl.lock().get();
+                for (auto const& entry : prepared)
+                    Distribute(id, connection, entry);
+                if (stats) {
+                    if (connection.stats)
+                        Enqueue(id, connection, PrepareStats(*stats, connection));
+                    connection.sendTimes.clear();
+                    connection.audioSendTimes.clear();
+                }
+                try {
+                    if (!Pump(hdl, connection))
+                        slow.emplace_back(hdl);
+                } catch (std::exception const& e) {
+                    logger.error("send failed: {}", e.what());
+                }
+            }
+        }
+        prepared.clear();
+        ClearBundles();
+
+        // closing can call the close handler, so do it without the lock
+        for (auto& hdl : slow) {
+            try {
+                logger.warn("disconnecting slow connection {}", hdl.lock().get());
+                socketServer.close(hdl, close::status::policy_violation, "connection too slow");
+            } catch (std::exception const& e) {
+                logger.error("closing slow connection failed: {}", e.what());
+            }
+        }
+        slow.clear();
+    }
+}
+
+static void Push(Pending next) {
+    TRACE_SCOPE("Socket::Send");
+    auto start = std::chrono::steady_clock::now();
+    next.queued = Now();
+    pending.Push(std::move(next));
+    if (!signaled.exchange(true))
+        pendingSignal.release();
+    uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    pushedPackets++;
+    blockedNanos += nanos;
+    uint64_t max = maxBlockedNanos;
+    while (nanos > max && !maxBlockedNanos.compare_exchange_weak(max, nanos))
+        ;
+}
+
+// must be called with connectionsMutex held
+static void UpdateAudioEncodings() {
+    uint32_t used = 0;
+    for (auto const& [_, connection] : connections)
+        used |= 1 << connection.encoding;
+    audioEncodings = used;
+}
+
+static void OpenHandler(connection_hdl connection) {
+    void* id = connection.lock().get();
+    logger.info("connected: {}", id);
+    std::unique_lock lock(connectionsMutex);
+    connections.emplace(connection, Connection());
+    UpdateAudioEncodings();
+    lock.unlock();
+    if (handlers.open)
+        handlers.open(id);
+}
+
+static void CloseHandler(connection_hdl connection) {
+    logger.info("disconnected: {}", connection.lock().get());
+    std::unique_lock lock(connectionsMutex);
+    connections.erase(connection);
+    UpdateAudioEncodings();
+    if (!connections.empty())
+        return;
+    lock.unlock();
+    if (handlers.empty)
+        handlers.empty();
+}
+
+static void MessageHandler(connection_hdl connection, server<config::asio>::message_ptr message) {
+    TRACE_SCOPE("Socket::MessageHandler");
+    if (Session::recording)
+        Session::Record(Session::Kind::Message, Now(), {(uint8_t const*) message->get_payload().data(), message->get_payload().size()});
+    PacketWrapper packet;
+    packet.ParseFromArray(message->get_payload().data(), message->get_payload().size());
+    void* source = connection.lock().get();
+    if (packet.has_input()) {
+        if (handlers.input)
+            handlers.input(packet.input());
+        return;
+    }
+    if (packet.has_feedback()) {
+        std::unique_lock lock(connectionsMutex);
+        auto found = connections.find(connection);
+        if (found != connections.end()) {
+            found->second.decodeQueue = packet.feedback().decodequeue();
+            found->second.latency = packet.feedback().latency();
+        }
+        return;
+    }
+    if (packet.has_settings()) {
+        std::unique_lock lock(connectionsMutex);
+        auto found = connections.find(connection);
+        if (found != connections.end()) {
+            // proto3 enums accept any value, and an unknown one would get no audio
+            auto encoding = packet.settings().audioencoding();
+            if (!AudioFrame_Encoding_IsValid(encoding)) {
+                logger.warn("connection {} asked for unknown audio encoding {}", source, (int) encoding);
+                encoding = AudioFrame::Float;
+            }
+            found->second.encoding = encoding;
+            found->second.stats = packet.settings().stats();
+            found->second.bundle = packet.settings().bundle();
+            UpdateAudioEncodings();
+        }
+    }
+    if (handlers.message)
+        handlers.message(std::move(packet), source);
+}
+
+// plain http requests on the same port, only used for scraping metrics
+static void HttpHandler(connection_hdl connection) {
+    auto con = socketServer.get_con_from_hdl(connection);
+    if (con->get_request().get_method() != "GET" || con->get_resource() != "/metrics") {
+        con->set_status(http::status_code::not_found);
+        return;
+    }
+    con->set_status(http::status_code::ok);
+    con->append_header("Content-Type", "text/plain; version=0.0.4");
+    con->set_body(Metrics::Serialize());
+}
+
+bool Socket::Start(int port) {
+    try {
+        socketServer.listen(lib::asio::ip::tcp::v4(), port);
+
+        socketServer.start_accept();
+
+        std::thread([]() {
+            threadRunning = true;
+            socketServer.run();
+            threadRunning = false;
+        }).detach();
+
+        lib::asio::error_code ec;
+        auto endpoint = socketServer.get_local_endpoint(ec);
+
+        if (ec.failed())
+            logger.error("not listening: {}", ec.message());
+        else {
+            logger.info(
+                "listening on {}:{} ipv4 {} ipv6 {}",
+                endpoint.address().to_string(ec),
+                endpoint.port(),
+                endpoint.address().is_v4(),
+                endpoint.address().is_v6()
+            );
+
+            if (endpoint.address().is_v4())
+                logger.debug("v4 {}:{}", endpoint.address().to_v4().to_string(ec), endpoint.port());
+
+            if (endpoint.address().is_v6())
+                logger.debug(
+                    "v6 {}:{} v4 compatible {}",
+                    endpoint.address().to_v6().to_string(ec),
+                    endpoint.port(),
+                    endpoint.address().to_v6().is_v4_compatible()
+                );
+        }
+
+        return true;
+    } catch (std::exception const& exc) {
+        logger.error("socket listen failed: {}", exc.what());
+        return false;
+    }
+}
+
+void Socket::Stop() {
+    try {
+        if (threadRunning) {
+            socketServer.stop_listening();
+
+            std::unique_lock lock(connectionsMutex);
+            for (auto& [connection, _] : connections)
+                socketServer.close(connection, close::status::going_away, "configuration change");
+            connections.clear();
+        }
+    } catch (std::exception const& exc) {
+        logger.error("socket closing failed: {}", exc.what());
+    }
+}
+
+bool Socket::IsRunning() {
+    return threadRunning;
+}
+
+bool Socket::HasConnections() {
+    std::shared_lock lock(connectionsMutex);
+    return !connections.empty();
+}
+
+void Socket::Init(Handlers set) {
+    if (initialized)
+        return;
+    handlers = std::move(set);
+
+    logger.info("initializing socket");
+    try {
+        socketServer.set_access_channels(log::alevel::none);
+        socketServer.set_error_channels(log::elevel::none);
+
+        socketServer.init_asio();
+        socketServer.set_reuse_addr(true);
+
+        socketServer.set_open_handler(OpenHandler);
+        socketServer.set_close_handler(CloseHandler);
+        socketServer.set_message_handler(MessageHandler);
+        socketServer.set_http_handler(HttpHandler);
+
+        messagePool.reserve(MaxPooledMessages);
+        std::thread(SenderThread).detach();
+        initialized = true;
+    } catch (std::exception const& exc) {
+        logger.error("socket init failed: {}", exc.what());
+    }
+}
+
+void Socket::Send(PacketWrapper packet, void* exclude) {
+    if (!packet.IsInitialized())
+        return;
+    auto type = packet.Packet_case();
+    Push({
+        .command = Command::Send,
+        .packet = std::move(packet),
+        .type = type,
+        .key = false,
+        .encoding = -1,
+        .exclude = exclude,
+        .target = nullptr,
+    });
+}
+
+void Socket::SendVideo(std::string&& serialized, bool key, FrameTimes times) {
+    Push({
+        .command = Command::Send,
+        .serialized = std::move(serialized),
+        .type = PacketWrapper::kVideoFrame,
+        .key = key,
+        .encoding = -1,
+        .exclude = nullptr,
+        .target = nullptr,
+        .times = times,
+    });
+}
+
+void Socket::SendTo(PacketWrapper packet, void* target) {
+    if (!packet.IsInitialized())
+        return;
+    auto type = packet.Packet_case();
+    Push({
+        .command = Command::Send,
+        .packet = std::move(packet),
+        .type = type,
+        .key = false,
+        .encoding = -1,
+        .exclude = nullptr,
+        .target = target,
+    });
+}
+
+void Socket::SendAudio(std::string&& serialized, AudioFrame::Encoding encoding) {
+    Push({
+        .command = Command::Send,
+        .serialized = std::move(serialized),
+        .type = PacketWrapper::kAudioFrame,
+        .key = false,
+        .encoding = encoding,
+        .exclude = nullptr,
+        .target = nullptr,
+    });
+}
+
+void Socket::SendAudioSamples(std::span<float const> samples, int sampleRate, int channels, uint64_t sample, uint64_t time) {
+    static std::vector<Encoding::AdpcmState> adpcmState;
+    // reused so its buffers keep their capacity
+    static PacketWrapper packet;
+    uint32_t encodings = audioEncodings;
+    for (auto encoding : {AudioFrame::Float, AudioFrame::Int16, AudioFrame::Adpcm}) {
+        if (!(encodings & (1 << encoding)))
+            continue;
+        Packet::SetAudioFrame(packet, samples, sampleRate, channels, sample, time, encoding, adpcmState);
+        SendAudio(Packet::Serialize(packet), encoding);
+    }
+}
+
+bool Socket::HasCachedVideo() {
+    return hasCachedVideo;
+}
+
+void Socket::SendCachedVideo(void* target, std::function<void()> missed) {
+    Push({.command = Command::ReplayVideo, .target = target, .missed = std::move(missed)});
+}
+
+void Socket::ClearCachedVideo() {
+    Push({.command = Command::ClearVideo});
+}
+
+uint32_t Socket::GetAudioEncodings() {
+    return audioEncodings;
+}
+
+std::vector<Socket::ConnectionStats> Socket::GetStats() {
+    std::vector<ConnectionStats> ret;
+    std::shared_lock lock(connectionsMutex);
+    for (auto const& [hdl, connection] : connections) {
+        size_t buffered = 0;
+        try {
+            buffered = socketServer.get_con_from_hdl(hdl)->get_buffered_amount();
+        } catch (...) {}
+        size_t queuedFrames = 0;
+        for (auto const& queue : connection.queues)
+            queuedFrames += queue.Size();
+        ret.push_back({
+            .id = hdl.lock().get(),
+            .queuedFrames = queuedFrames,
+            .queuedBytes = connection.queuedBytes,
+            .bufferedBytes = buffered,
+            .sentFrames = connection.sentFrames,
+            .sentMessages = connection.sentMessages,
+            .sentBytes = connection.sentBytes,
+            .droppedFrames = connection.droppedFrames,
+            .decodeQueue = connection.decodeQueue,
+            .latency = connection.latency,
+        });
+    }
+    return ret;
+}
+
+Socket::SenderStats Socket::GetSenderStats() {
+    return {
+        .pushedPackets = pushedPackets,
+        .blockedNanos = blockedNanos,
+        .maxBlockedNanos = maxBlockedNanos,
+    };
+}
@@ -0,0 +1,151 @@
+#include "trace.hpp"
+
+#include <pthread.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log.hpp"
+
+static constexpr Log::Logger logger{};
+
+// per thread, events past this are dropped until the next recording
+static constexpr size_t BufferEvents = 1 << 16;
+
+struct Event {
+    char const* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct Buffer {
+    std::unique_ptr<Event[]> events = std::make_unique<Event[]>(BufferEvents);
+    // only written by the owning thread
+    std::atomic<size_t> count = 0;
+    std::atomic<uint32_t> generation = 0;
+    int id;
+    std::string thread;
+};
+
+// buffers are kept until exit, since threads may still be writing to them
+static std::mutex buffersMutex;
+static std::vector<std::unique_ptr<Buffer>> buffers;
+static thread_local Buffer* threadBuffer = nullptr;
+
+// incremented for every recording, so threads know to reset their buffers
+static std::atomic<uint32_t> generation = 0;
+// recording can't start again until the previous one is written
+static std::atomic_bool writing = false;
+static std::string traceDirectory = ".";
+
+static Buffer* GetBuffer() {
+    if (threadBuffer)
+        return threadBuffer;
+    auto buffer = std::make_unique<Buffer>();
+    char name[16] = "";
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    buffer->thread = name;
+    std::unique_lock lock(buffersMutex);
+    buffer->id = buffers.size() + 1;
+    threadBuffer = buffers.emplace_back(std::move(buffer)).get();
+    return threadBuffer;
+}
+
+static void Write(uint32_t recording) {
+    std::vector<Buffer*> snapshot;
+    {
+        std::unique_lock lock(buffersMutex);
+        for (auto& buffer : buffers)
+            snapshot.emplace_back(buffer.get());
+    }
+
+    auto directory = std::filesystem::path(traceDirectory);
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    auto path = directory / fmt::format("trace_{}.json", time);
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::ofstream file(path);
+    if (!file) {
+        logger.error("failed to open trace file {}", path.string());
+        writing = false;
+        return;
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    size_t total = 0;
+    for (auto buffer : snapshot) {
+        // generation is stored after resetting count, so a matching generation means count is from this recording
+        if (buffer->generation.load(std::memory_order_acquire) != recording)
+            continue;
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        if (count == 0)
+            continue;
+        file << (first ? "" : ",")
+             << fmt::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})", buffer->id, buffer->thread);
+        first = false;
+        for (size_t i = 0; i < count; i++) {
+            auto const& event = buffer->events[i];
+            file << fmt::format(
+                R"(,{{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                event.name,
+                buffer->id,
+                event.start / 1e3,
+                (event.end - event.start) / 1e3
+            );
+        }
+        total += count;
+    }
+    file << "]}";
+    file.close();
+
+    logger.info("wrote {} trace events to {}", total, path.string());
+    writing = false;
+}
+
+void Trace::SetDirectory(std::string directory) {
+    traceDirectory = std::move(directory);
+}
+
+void Trace::Start() {
+    if (enabled)
+        return;
+    if (writing) {
+        logger.warn("not starting trace while the previous one is being written");
+        return;
+    }
+    logger.info("starting trace");
+    generation++;
+    enabled = true;
+}
+
+void Trace::Stop() {
+    if (!enabled.exchange(false))
+        return;
+    writing = true;
+    std::thread(Write, generation.load()).detach();
+}
+
+uint64_t Trace::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::Record(char const* name, uint64_t start, uint64_t end) {
+    auto buffer = GetBuffer();
+    uint32_t current = generation.load(std::memory_order_relaxed);
+    if (buffer->generation.load(std::memory_order_relaxed) != current) {
+        buffer->count.store(0, std::memory_order_relaxed);
+        buffer->generation.store(current, std::memory_order_release);
+    }
+    size_t index = buffer->count.load(std::memory_order_relaxed);
+    if (index >= BufferEvents)
+        return;
+    buffer->events[index] = {name, start, end};
+    buffer->count.store(index + 1, std::memory_order_release);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "encoding.hpp"
+
+static constexpr int IndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static constexpr int StepTable[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,    31,    34,    37,
+    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,   130,   143,   157,   173,   190,   209,
+    230,   253,   279,   307,   337,   371,   408,   449,   494,   544,   598,   658,   724,   796,   876,   963,   1060,  1166,
+    1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,
+    7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+// a standard ima adpcm decoder for the layout described in encoding.cpp
+static std::vector<float> DecodeAdpcm(std::string const& data, int channels) {
+    std::vector<Encoding::AdpcmState> state(channels);
+    auto bytes = (uint8_t const*) data.data();
+    for (auto& channel : state) {
+        channel.predictor = (int16_t) (bytes[0] | (bytes[1] << 8));
+        channel.index = bytes[2];
+        bytes += 4;
+    }
+    size_t count = (data.size() - channels * 4) * 2;
+    std::vector<float> ret;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t nibble = i % 2 == 0 ? bytes[i / 2] & 0xf : bytes[i / 2] >> 4;
+        auto& channel = state[i % channels];
+        int step = StepTable[channel.index];
+        int delta = step >> 3;
+        if (nibble & 4)
+            delta += step;
+        if (nibble & 2)
+            delta += step >> 1;
+        if (nibble & 1)
+            delta += step >> 2;
+        channel.predictor = std::clamp(channel.predictor + (nibble & 8 ? -delta : delta), -32768, 32767);
+        channel.index = std::clamp(channel.index + IndexTable[nibble], 0, 88);
+        ret.push_back(channel.predictor / 32767.0f);
+    }
+    return ret;
+}
+
+static std::vector<float> Tone(size_t frames, int channels) {
+    std::vector<float> ret(frames * channels);
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < channels; c++)
+            ret[i * channels + c] = 0.5f * std::sin(2 * M_PI * (440 + 220 * c) * i / 48000);
+    }
+    return ret;
+}
+
+TEST(Encoding, Int16IsLittleEndianAndClamped) {
+    std::vector<float> samples = {0, 1, -1, 2, 0.5};
+    std::string out;
+    Encoding::Int16(samples, out);
+    ASSERT_EQ(out.size(), samples.size() * 2);
+    auto value = [&out](size_t i) { return (int16_t) ((uint8_t) out[i * 2] | ((uint8_t) out[i * 2 + 1] << 8)); };
+    EXPECT_EQ(value(0), 0);
+    EXPECT_EQ(value(1), 32767);
+    EXPECT_EQ(value(2), -32767);
+    EXPECT_EQ(value(3), 32767);
+    EXPECT_EQ(value(4), 16384);
+}
+
+TEST(Encoding, AdpcmRoundTrip) {
+    int channels = 2;
+    auto samples = Tone(4800, channels);
+    std::vector<Encoding::AdpcmState> state;
+    double error = 0;
+    // several packets, each continuing from the state the last one ended with
+    for (size_t start = 0; start < samples.size(); start += 960) {
+        std::span<float const> packet(samples.data() + start, 960);
+        std::string out;
+        Encoding::Adpcm(packet, channels, state, out);
+        ASSERT_EQ(out.size(), channels * 4 + packet.size() / 2);
+        auto decoded = DecodeAdpcm(out, channels);
+        ASSERT_EQ(decoded.size(), packet.size());
+        for (size_t i = 0; i < packet.size(); i++)
+            error += (decoded[i] - packet[i]) * (decoded[i] - packet[i]);
+    }
+    // 4 bit adpcm of a clean tone stays well under 1% rms error
+    EXPECT_LT(std::sqrt(error / samples.size()), 0.01);
+}
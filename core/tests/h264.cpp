@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "h264.hpp"
+
+using H264::NalType;
+
+// a nal with a four byte start code and a few bytes of payload
+static void AddNal(std::vector<uint8_t>& stream, NalType type, size_t size = 8, bool longCode = true) {
+    if (longCode)
+        stream.push_back(0);
+    stream.insert(stream.end(), {0, 0, 1, (uint8_t) (0x60 | (uint8_t) type)});
+    stream.insert(stream.end(), size, 0xab);
+}
+
+static std::vector<uint8_t> Unit(std::initializer_list<NalType> types) {
+    std::vector<uint8_t> ret;
+    for (auto type : types)
+        AddNal(ret, type);
+    return ret;
+}
+
+TEST(H264, ForEachNalSplitsOnBothStartCodes) {
+    std::vector<uint8_t> stream;
+    AddNal(stream, NalType::Sps, 4, true);
+    AddNal(stream, NalType::Pps, 3, false);
+    AddNal(stream, NalType::Idr, 20, true);
+
+    std::vector<H264::Nal> nals;
+    H264::ForEachNal(stream, [&nals](H264::Nal const& nal) { nals.push_back(nal); });
+    ASSERT_EQ(nals.size(), 3);
+    EXPECT_EQ(nals[0].type, NalType::Sps);
+    EXPECT_EQ(nals[0].data.size(), 4 + 1 + 4);
+    EXPECT_EQ(nals[1].type, NalType::Pps);
+    EXPECT_EQ(nals[1].data.size(), 3 + 1 + 3);
+    EXPECT_EQ(nals[2].type, NalType::Idr);
+    EXPECT_EQ(nals[2].data.size(), 4 + 1 + 20);
+    EXPECT_EQ(nals[2].data.data() + nals[2].data.size(), stream.data() + stream.size());
+}
+
+TEST(H264, AssemblerHoldsParameterSetsForTheNextIdr) {
+    H264::Assembler assembler;
+    auto config = Unit({NalType::Sps, NalType::Pps});
+    EXPECT_FALSE(assembler.Add(config));
+
+    auto idr = Unit({NalType::Idr});
+    auto key = assembler.Add(idr);
+    ASSERT_TRUE(key);
+    EXPECT_TRUE(key->key);
+    EXPECT_EQ(std::vector(key->parameterSets.begin(), key->parameterSets.end()), config);
+    EXPECT_EQ(key->data.data(), idr.data());
+
+    auto slice = Unit({NalType::Slice});
+    auto delta = assembler.Add(slice);
+    ASSERT_TRUE(delta);
+    EXPECT_FALSE(delta->key);
+    EXPECT_TRUE(delta->parameterSets.empty());
+}
+
+TEST(H264, AssemblerKeepsInlineParameterSets) {
+    H264::Assembler assembler;
+    auto unit = Unit({NalType::Delimiter, NalType::Sps, NalType::Pps, NalType::Sei, NalType::Idr});
+    auto key = assembler.Add(unit);
+    ASSERT_TRUE(key);
+    EXPECT_TRUE(key->key);
+    // already in the unit, so nothing is added in front
+    EXPECT_TRUE(key->parameterSets.empty());
+
+    // and remembered for an idr without them
+    auto idr = Unit({NalType::Delimiter, NalType::Idr});
+    auto next = assembler.Add(idr);
+    ASSERT_TRUE(next);
+    EXPECT_TRUE(next->key);
+    EXPECT_FALSE(next->parameterSets.empty());
+}
+
+TEST(H264, AssemblerResetForgetsParameterSets) {
+    H264::Assembler assembler;
+    assembler.Add(Unit({NalType::Sps, NalType::Pps}));
+    assembler.Reset();
+    auto key = assembler.Add(Unit({NalType::Idr}));
+    ASSERT_TRUE(key);
+    EXPECT_TRUE(key->parameterSets.empty());
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "mixing.hpp"
+
+using Mixing::Mode;
+
+// odd sizes so the scalar tail after the vector loop is covered too
+static constexpr size_t Sizes[] = {0, 1, 3, 4, 7, 64, 1066, 1599};
+
+static std::vector<float> Noise(size_t count, int seed) {
+    std::vector<float> ret(count);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-1, 1);
+    for (auto& sample : ret)
+        sample = noise(rng);
+    return ret;
+}
+
+TEST(Mixing, ScaleMatchesReference) {
+    for (size_t size : Sizes) {
+        auto src = Noise(size, 1);
+        std::vector<float> expected(size), actual(size);
+        Mixing::Reference::Scale(expected.data(), src.data(), size, 0.8);
+        Mixing::Scale(actual.data(), src.data(), size, 0.8);
+        for (size_t i = 0; i < size; i++)
+            ASSERT_FLOAT_EQ(actual[i], expected[i]) << "size " << size << " index " << i;
+
+        // in place, like ScaledInsert's callers
+        Mixing::Scale(src.data(), src.data(), size, 0.8);
+        EXPECT_EQ(src, actual);
+    }
+}
+
+template <Mode M>
+static void ExpectMixMatchesReference(bool hasMicData) {
+    for (size_t size : Sizes) {
+        auto mic = Noise(size, 2);
+        auto expected = Noise(size, 3);
+        auto actual = expected;
+        Mixing::Reference::Mix<M>(expected.data(), mic.data(), size, hasMicData);
+        Mixing::Mix<M>(actual.data(), mic.data(), size, hasMicData);
+        for (size_t i = 0; i < size; i++)
+            ASSERT_FLOAT_EQ(actual[i], expected[i]) << "mode " << (int) M << " size " << size << " index " << i;
+    }
+}
+
+TEST(Mixing, MixMatchesReference) {
+    for (bool hasMicData : {true, false}) {
+        ExpectMixMatchesReference<Mode::Combine>(hasMicData);
+        ExpectMixMatchesReference<Mode::Duck>(hasMicData);
+        ExpectMixMatchesReference<Mode::Add>(hasMicData);
+    }
+}
+
+TEST(Mixing, MixReadMatchesReferenceAcrossTheWrap) {
+    RingBuffer<float> buffer(1024);
+    // leave the read position near the end so the mic samples come back in two regions
+    std::vector<float> skip(1000);
+    Mixing::ScaledInsert(buffer, skip.data(), skip.size(), 1);
+    buffer.CommitRead(skip.size());
+
+    auto mic = Noise(600, 2);
+    auto expected = Noise(600, 3);
+    auto actual = expected;
+    Mixing::ScaledInsert(buffer, mic.data(), mic.size(), 0.5);
+    Mixing::MixRead(Mode::Combine, buffer, actual.data(), actual.size(), true);
+    Mixing::Reference::Scale(mic.data(), mic.data(), mic.size(), 0.5);
+    Mixing::Reference::Mix<Mode::Combine>(expected.data(), mic.data(), expected.size(), true);
+    for (size_t i = 0; i < expected.size(); i++)
+        ASSERT_FLOAT_EQ(actual[i], expected[i]) << "index " << i;
+    EXPECT_EQ(buffer.Available(), 0);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include "packet.hpp"
+#include "pool.hpp"
+
+static std::vector<uint8_t> Bytes(size_t size, uint8_t value) {
+    return std::vector<uint8_t>(size, value);
+}
+
+TEST(Packet, WriteVideoFrameParses) {
+    auto prefix = Bytes(20, 0x42);
+    auto data = Bytes(1000, 0x5a);
+    std::string out;
+    Packet::WriteVideoFrame(out, prefix, data, 123456789, true);
+
+    PacketWrapper packet;
+    ASSERT_TRUE(packet.ParseFromString(out));
+    ASSERT_TRUE(packet.has_videoframe());
+    auto& frame = packet.videoframe();
+    EXPECT_EQ(frame.data().size(), prefix.size() + data.size());
+    EXPECT_EQ(frame.data().substr(0, prefix.size()), std::string(prefix.begin(), prefix.end()));
+    EXPECT_EQ(frame.data().substr(prefix.size()), std::string(data.begin(), data.end()));
+    EXPECT_EQ(frame.time(), 123456789);
+    EXPECT_TRUE(frame.key());
+    EXPECT_LE(out.size(), prefix.size() + data.size() + Packet::MaxVideoFrameOverhead);
+}
+
+TEST(Packet, WriteVideoFrameMatchesProtobuf) {
+    auto data = Bytes(300, 7);
+    std::string out;
+    Packet::WriteVideoFrame(out, {}, data, 0, false);
+
+    PacketWrapper packet;
+    packet.mutable_videoframe()->set_data(std::string(data.begin(), data.end()));
+    EXPECT_EQ(out, packet.SerializeAsString());
+}
+
+TEST(Packet, WriteBundleParses) {
+    std::vector<Encoding::AdpcmState> state;
+    std::vector<float> samples(960, 0.25);
+    PacketWrapper audio;
+    Packet::SetAudioFrame(audio, samples, 48000, 2, 0, 100, AudioFrame::Float, state);
+    auto first = audio.SerializeAsString();
+    Packet::SetAudioFrame(audio, samples, 48000, 2, 480, 200, AudioFrame::Int16, state);
+    auto second = audio.SerializeAsString();
+    std::string video;
+    Packet::WriteVideoFrame(video, {}, Bytes(500, 1), 300, true);
+
+    std::string const* parts[] = {&first, &second, &video};
+    std::string out;
+    Packet::WriteBundle(out, parts);
+
+    PacketWrapper packet;
+    ASSERT_TRUE(packet.ParseFromString(out));
+    ASSERT_TRUE(packet.has_bundle());
+    auto& bundle = packet.bundle();
+    ASSERT_EQ(bundle.audioframes_size(), 2);
+    EXPECT_EQ(bundle.audioframes(0).time(), 100);
+    EXPECT_EQ(bundle.audioframes(0).data_size(), samples.size());
+    EXPECT_EQ(bundle.audioframes(1).sample(), 480);
+    EXPECT_EQ(bundle.audioframes(1).encoding(), AudioFrame::Int16);
+    EXPECT_EQ(bundle.videoframe().time(), 300);
+    EXPECT_TRUE(bundle.videoframe().key());
+    EXPECT_LE(out.size(), first.size() + second.size() + video.size() + Packet::MaxBundleOverhead);
+}
+
+TEST(Packet, WriteBundleWithoutVideo) {
+    PacketWrapper audio;
+    audio.mutable_audioframe()->set_time(5);
+    auto serialized = audio.SerializeAsString();
+    std::string const* parts[] = {&serialized};
+    std::string out;
+    Packet::WriteBundle(out, parts);
+
+    PacketWrapper packet;
+    ASSERT_TRUE(packet.ParseFromString(out));
+    EXPECT_EQ(packet.bundle().audioframes_size(), 1);
+    EXPECT_FALSE(packet.bundle().has_videoframe());
+}
+
+TEST(Packet, SerializeMatchesProtobuf) {
+    PacketWrapper packet;
+    packet.mutable_settings()->set_bitrate(10000);
+    packet.mutable_settings()->set_fps(60);
+    auto out = Packet::Serialize(packet);
+    EXPECT_EQ(out, packet.SerializeAsString());
+    Pool::Release(std::move(out));
+}
+
+TEST(Packet, SetAudioFrameReplacesPreviousSamples) {
+    std::vector<Encoding::AdpcmState> state;
+    std::vector<float> samples(100, 0.5);
+    PacketWrapper packet;
+    Packet::SetAudioFrame(packet, samples, 48000, 2, 0, 0, AudioFrame::Float, state);
+    EXPECT_EQ(packet.audioframe().data_size(), samples.size());
+    EXPECT_TRUE(packet.audioframe().encodeddata().empty());
+
+    Packet::SetAudioFrame(packet, samples, 48000, 2, 50, 0, AudioFrame::Int16, state);
+    EXPECT_EQ(packet.audioframe().data_size(), 0);
+    EXPECT_EQ(packet.audioframe().encodeddata().size(), samples.size() * sizeof(int16_t));
+
+    Packet::SetAudioFrame(packet, samples, 48000, 2, 100, 0, AudioFrame::Adpcm, state);
+    // a header per channel and two samples per byte
+    EXPECT_EQ(packet.audioframe().encodeddata().size(), 2 * 4 + samples.size() / 2);
+    EXPECT_EQ(packet.audioframe().sample(), 100);
+}
+
+struct Sent {
+    size_t samples;
+    uint64_t sample;
+    uint64_t time;
+};
+
+static Packet::AudioSplitter::Send Collect(std::vector<Sent>& sent) {
+    return [&sent](std::span<float const> packet, int, int, uint64_t sample, uint64_t time) { sent.push_back({packet.size(), sample, time}); };
+}
+
+TEST(AudioSplitter, SplitsIntoTimestampedPackets) {
+    Packet::AudioSplitter splitter;
+    std::vector<Sent> sent;
+    std::vector<float> samples(1000 * 2);
+    uint64_t start = 1'000'000'000;
+    splitter.Add(samples, 48000, 2, 10, start, Collect(sent));
+
+    // 10 ms of stereo is 480 frames, the remaining 40 wait for the next call
+    ASSERT_EQ(sent.size(), 2);
+    EXPECT_EQ(sent[0].samples, 960);
+    EXPECT_EQ(sent[0].sample, 0);
+    EXPECT_EQ(sent[0].time, start);
+    EXPECT_EQ(sent[1].sample, 480);
+    EXPECT_EQ(sent[1].time, start + 10'000'000);
+
+    splitter.Add(std::span(samples).subspan(0, 440 * 2), 48000, 2, 10, start + 20'000'000, Collect(sent));
+    ASSERT_EQ(sent.size(), 3);
+    EXPECT_EQ(sent[2].sample, 960);
+    EXPECT_EQ(sent[2].time, start + 20'000'000);
+}
+
+TEST(AudioSplitter, RestartsWhenTheFormatChanges) {
+    Packet::AudioSplitter splitter;
+    std::vector<Sent> sent;
+    std::vector<float> samples(480 * 2);
+    splitter.Add(samples, 48000, 2, 10, 0, Collect(sent));
+    splitter.Add(std::span(samples).subspan(0, 441), 44100, 1, 10, 5'000'000'000, Collect(sent));
+    ASSERT_EQ(sent.size(), 2);
+    EXPECT_EQ(sent[1].sample, 0);
+    EXPECT_EQ(sent[1].time, 5'000'000'000);
+}
+
+TEST(AudioSplitter, ReanchorsAfterDrift) {
+    Packet::AudioSplitter splitter;
+    std::vector<Sent> sent;
+    std::vector<float> samples(480 * 2);
+    splitter.Add(samples, 48000, 2, 10, 0, Collect(sent));
+    // a second of silence from the game, far more than the allowed drift
+    splitter.Add(samples, 48000, 2, 10, 1'000'000'000, Collect(sent));
+    ASSERT_EQ(sent.size(), 2);
+    EXPECT_EQ(sent[1].sample, 480);
+    // the samples end when they were received, so the packet starts one packet length earlier
+    EXPECT_EQ(sent[1].time, 990'000'000);
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "queue.hpp"
+
+TEST(MpscQueue, PopsInOrder) {
+    MpscQueue<std::string> queue;
+    EXPECT_FALSE(queue.Pop());
+    queue.Push("a");
+    queue.Push("b");
+    EXPECT_EQ(queue.Pop(), "a");
+    queue.Push("c");
+    EXPECT_EQ(queue.Pop(), "b");
+    EXPECT_EQ(queue.Pop(), "c");
+    EXPECT_FALSE(queue.Pop());
+}
+
+TEST(MpscQueue, ReusesNodes) {
+    MpscQueue<int> queue;
+    // nodes go through the free list many times over
+    for (int i = 0; i < 10000; i++) {
+        queue.Push(i);
+        queue.Push(i + 1);
+        ASSERT_EQ(queue.Pop(), i);
+        ASSERT_EQ(queue.Pop(), i + 1);
+    }
+    EXPECT_FALSE(queue.Pop());
+}
+
+TEST(MpscQueue, KeepsOrderForEachProducer) {
+    constexpr int Producers = 4;
+    constexpr int Count = 20000;
+    MpscQueue<std::pair<int, int>> queue;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < Producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < Count; i++)
+                queue.Push({p, i});
+        });
+    }
+    std::vector<int> next(Producers, 0);
+    int received = 0;
+    while (received < Producers * Count) {
+        if (auto value = queue.Pop()) {
+            ASSERT_EQ(value->second, next[value->first]++);
+            received++;
+        } else
+            std::this_thread::yield();
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_FALSE(queue.Pop());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "ringbuffer.hpp"
+
+static void Write(RingBuffer<int>& buffer, int first, size_t count) {
+    size_t written = 0;
+    for (auto region : buffer.PrepareWrite(count)) {
+        for (auto& value : region)
+            value = first + written++;
+    }
+    buffer.CommitWrite(written);
+}
+
+TEST(RingBuffer, RoundsCapacityUp) {
+    RingBuffer<int> buffer(100);
+    EXPECT_EQ(buffer.Capacity(), 128);
+    EXPECT_EQ(buffer.Free(), 128);
+    EXPECT_EQ(buffer.Available(), 0);
+}
+
+TEST(RingBuffer, SplitsRegionsWhereItWraps) {
+    RingBuffer<int> buffer(8);
+    Write(buffer, 0, 6);
+    buffer.CommitRead(6);
+    Write(buffer, 10, 5);
+
+    auto regions = buffer.PrepareRead(5);
+    ASSERT_EQ(regions[0].size(), 2);
+    ASSERT_EQ(regions[1].size(), 3);
+    EXPECT_EQ(regions[0][0], 10);
+    EXPECT_EQ(regions[0][1], 11);
+    EXPECT_EQ(regions[1][0], 12);
+    EXPECT_EQ(regions[1][2], 14);
+}
+
+TEST(RingBuffer, DropsWhatDoesNotFit) {
+    RingBuffer<int> buffer(4);
+    Write(buffer, 0, 10);
+    EXPECT_EQ(buffer.Available(), 4);
+    EXPECT_EQ(buffer.Free(), 0);
+    buffer.Clear();
+    EXPECT_EQ(buffer.Available(), 0);
+    EXPECT_EQ(buffer.Free(), 4);
+}
+
+TEST(RingBuffer, KeepsOrderAcrossThreads) {
+    RingBuffer<int> buffer(64);
+    constexpr int Count = 100000;
+    std::thread producer([&buffer]() {
+        int next = 0;
+        while (next < Count) {
+            size_t count = std::min<size_t>(buffer.Free(), Count - next);
+            Write(buffer, next, count);
+            next += count;
+            std::this_thread::yield();
+        }
+    });
+    int expected = 0;
+    while (expected < Count) {
+        size_t available = buffer.Available();
+        for (auto region : buffer.PrepareRead(available)) {
+            for (int value : region)
+                ASSERT_EQ(value, expected++);
+        }
+        buffer.CommitRead(available);
+        std::this_thread::yield();
+    }
+    producer.join();
+}
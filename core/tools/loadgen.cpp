@@ -0,0 +1,391 @@
+// opens many viewer connections to a server and reports how well each one is kept up to date
+// stream-loadgen --clients 8 --duration 30 [--serve] [--host 192.168.1.2] [--port 3308]
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <websocketpp/client.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+
+#include "log.hpp"
+#include "packet.hpp"
+#include "pool.hpp"
+#include "socket.hpp"
+
+using Client = websocketpp::client<websocketpp::config::asio_client>;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 3308;
+    int clients = 4;
+    int threads = 1;
+    int duration = 10;
+    float inputRate = 0;
+    float settingsRate = 0;
+    AudioFrame::Encoding encoding = AudioFrame::Float;
+    bool bundle = false;
+    bool serve = false;
+    int bitrate = 10000;
+    int fps = 60;
+};
+
+// only touched from the connection's own handlers, which websocketpp never runs concurrently
+struct Viewer {
+    websocketpp::connection_hdl hdl;
+    bool open = false;
+    uint64_t bytes = 0;
+    uint64_t messages = 0;
+    uint64_t videoFrames = 0;
+    uint64_t audioFrames = 0;
+    uint64_t lastVideo = 0;
+    // microseconds
+    std::vector<uint32_t> videoGaps;
+    std::vector<uint32_t> videoLatency;
+    std::vector<uint32_t> audioLatency;
+    // the last settings from the server, echoed back like the real client does
+    std::mutex settingsMutex;
+    std::optional<Settings> settings;
+};
+
+static inline uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t Micros(uint64_t from, uint64_t to) {
+    return to > from ? std::min<uint64_t>((to - from) / 1000, UINT32_MAX) : 0;
+}
+
+static std::string Summary(std::vector<uint32_t>& values) {
+    if (values.empty())
+        return "-";
+    std::sort(values.begin(), values.end());
+    auto percentile = [&values](float p) { return values[std::min(values.size() - 1, (size_t) (p * values.size()))] / 1000.0; };
+    return fmt::format("{:.1f}/{:.1f}/{:.1f}", percentile(0.5), percentile(0.99), values.back() / 1000.0);
+}
+
+static void Usage() {
+    fmt::print(
+        "usage: stream-loadgen [options]\n"
+        "  --host <address>       server to connect to, default 127.0.0.1\n"
+        "  --port <port>          default 3308\n"
+        "  --clients <n>          connections to open, default 4\n"
+        "  --threads <n>          threads handling the connections, default 1\n"
+        "  --duration <seconds>   default 10\n"
+        "  --input-rate <hz>      input packets sent by each client per second, default 0\n"
+        "  --settings-rate <hz>   settings echoed by each client per second, default 0\n"
+        "  --encoding <name>      audio encoding to request: float, int16 or adpcm\n"
+        "  --bundle               request audio and video together in bundles\n"
+        "  --serve                run the core server in process with synthetic video and audio\n"
+        "  --bitrate <kbps>       video bitrate with --serve, default 10000\n"
+        "  --fps <n>              video frame rate with --serve, default 60\n"
+        "latencies are only meaningful when the server shares this machine's monotonic clock\n"
+    );
+}
+
+static std::optional<Options> Parse(int argc, char** argv) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument(std::string(arg));
+                return argv[++i];
+            };
+            if (arg == "--host")
+                options.host = next();
+            else if (arg == "--port")
+                options.port = std::stoi(next());
+            else if (arg == "--clients")
+                options.clients = std::stoi(next());
+            else if (arg == "--threads")
+                options.threads = std::max(std::stoi(next()), 1);
+            else if (arg == "--duration")
+                options.duration = std::stoi(next());
+            else if (arg == "--input-rate")
+                options.inputRate = std::stof(next());
+            else if (arg == "--settings-rate")
+                options.settingsRate = std::stof(next());
+            else if (arg == "--encoding") {
+                std::string name = next();
+                if (name == "int16")
+                    options.encoding = AudioFrame::Int16;
+                else if (name == "adpcm")
+                    options.encoding = AudioFrame::Adpcm;
+                else if (name != "float")
+                    throw std::invalid_argument(name);
+            } else if (arg == "--bundle")
+                options.bundle = true;
+            else if (arg == "--serve")
+                options.serve = true;
+            else if (arg == "--bitrate")
+                options.bitrate = std::stoi(next());
+            else if (arg == "--fps") {
+                options.fps = std::stoi(next());
+                if (options.fps <= 0)
+                    throw std::invalid_argument(std::string(arg));
+            } else
+                throw std::invalid_argument(std::string(arg));
+        }
+    } catch (std::exception const& exc) {
+        fmt::print(stderr, "invalid argument: {}\n", exc.what());
+        return std::nullopt;
+    }
+    return options;
+}
+
+static void HandleVideo(Viewer& viewer, VideoFrame const& frame, uint64_t now) {
+    viewer.videoFrames++;
+    if (viewer.lastVideo)
+        viewer.videoGaps.push_back(Micros(viewer.lastVideo, now));
+    viewer.lastVideo = now;
+    viewer.videoLatency.push_back(Micros(frame.time(), now));
+}
+
+static void HandleAudio(Viewer& viewer, AudioFrame const& frame, uint64_t now) {
+    viewer.audioFrames++;
+    viewer.audioLatency.push_back(Micros(frame.time(), now));
+}
+
+// returns whether the packet was settings from the server
+static bool HandleMessage(Viewer& viewer, std::string const& payload) {
+    uint64_t now = Now();
+    viewer.bytes += payload.size();
+    viewer.messages++;
+    PacketWrapper packet;
+    if (!packet.ParseFromString(payload))
+        return false;
+    if (packet.has_videoframe())
+        HandleVideo(viewer, packet.videoframe(), now);
+    else if (packet.has_audioframe())
+        HandleAudio(viewer, packet.audioframe(), now);
+    else if (packet.has_bundle()) {
+        for (auto const& audio : packet.bundle().audioframes())
+            HandleAudio(viewer, audio, now);
+        if (packet.bundle().has_videoframe())
+            HandleVideo(viewer, packet.bundle().videoframe(), now);
+    } else if (packet.has_settings()) {
+        std::unique_lock lock(viewer.settingsMutex);
+        viewer.settings = packet.settings();
+        return true;
+    }
+    return false;
+}
+
+// the server applies every field, so nothing is sent until its own settings have arrived to echo back, like the web client
+static void SendSettings(Client& client, Viewer& viewer, Options const& options) {
+    PacketWrapper packet;
+    {
+        std::unique_lock lock(viewer.settingsMutex);
+        if (!viewer.settings)
+            return;
+        *packet.mutable_settings() = *viewer.settings;
+    }
+    packet.mutable_settings()->set_audioencoding(options.encoding);
+    packet.mutable_settings()->set_bundle(options.bundle);
+    websocketpp::lib::error_code ec;
+    client.send(viewer.hdl, packet.SerializeAsString(), websocketpp::frame::opcode::binary, ec);
+}
+
+// sets the bit for a key code from src/accumulator.cpp in a mask of 32 bit words
+static void AddKey(google::protobuf::RepeatedField<uint32_t>& mask, uint8_t key) {
+    while (mask.size() <= key / 32)
+        mask.Add(0);
+    mask.Set(key / 32, mask.Get(key / 32) | (1u << (key % 32)));
+}
+
+static void SendInput(Client& client, Viewer& viewer, uint64_t count) {
+    PacketWrapper packet;
+    auto& input = *packet.mutable_input();
+    // small circular mouse movements, with a key press now and then
+    input.set_dx((count % 20) < 10 ? 1 : -1);
+    input.set_dy((count % 40) < 20 ? 1 : -1);
+    if (count % 30 == 0)
+        AddKey(*input.mutable_keysdownmask(), 'W');
+    else if (count % 30 == 15)
+        AddKey(*input.mutable_keysupmask(), 'W');
+    websocketpp::lib::error_code ec;
+    client.send(viewer.hdl, packet.SerializeAsString(), websocketpp::frame::opcode::binary, ec);
+}
+
+// synthetic stand-in for the encoder and audio capture, sending through the core socket
+static void Serve(Options const& options, std::atomic_bool& running) {
+    // new connections get settings like they do from the mod, which the viewers echo with their encoding
+    Socket::Init({.open = [](void* connection) {
+        PacketWrapper packet;
+        packet.mutable_settings();
+        Socket::SendTo(std::move(packet), connection);
+    }});
+    if (!Socket::Start(options.port)) {
+        running = false;
+        return;
+    }
+
+    std::vector<uint8_t> unit(options.bitrate * 1000 / 8 / options.fps, 0x5a);
+    std::vector<uint8_t> parameterSets(32, 0x42);
+    std::vector<float> samples(480 * 2);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = 0.5f * std::sin(i * 0.05f);
+
+    auto frameInterval = std::chrono::nanoseconds(1'000'000'000 / options.fps);
+    auto audioInterval = std::chrono::milliseconds(10);
+    auto nextFrame = std::chrono::steady_clock::now();
+    auto nextAudio = nextFrame;
+    uint64_t frame = 0;
+    uint64_t sample = 0;
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextFrame) {
+            // a key frame every second so new connections can start
+            bool key = frame % options.fps == 0;
+            uint64_t time = Now();
+            auto serialized = Pool::Acquire(unit.size() + parameterSets.size() + Packet::MaxVideoFrameOverhead);
+            Packet::WriteVideoFrame(serialized, key ? std::span(parameterSets) : std::span<uint8_t const>(), unit, time, key);
+            Socket::SendVideo(std::move(serialized), key, {.capture = time, .encoded = time});
+            nextFrame += frameInterval;
+            frame++;
+        }
+        if (now >= nextAudio) {
+            Socket::SendAudioSamples(samples, 48000, 2, sample, Now());
+            nextAudio += audioInterval;
+            sample += 480;
+        }
+        std::this_thread::sleep_until(std::min(nextFrame, nextAudio));
+    }
+    Socket::Stop();
+}
+
+static void Quiet(Log::Level level, std::string const& message) {
+    if (level >= Log::Level::Warn)
+        fmt::print(stderr, "{}\n", message);
+}
+
+int main(int argc, char** argv) {
+    auto parsed = Parse(argc, argv);
+    if (!parsed) {
+        Usage();
+        return 1;
+    }
+    auto options = *parsed;
+    Log::SetSink(Quiet);
+
+    std::atomic_bool running = true;
+    std::thread server;
+    if (options.serve) {
+        server = std::thread(Serve, std::cref(options), std::ref(running));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!running) {
+            server.join();
+            fmt::print(stderr, "server failed to start\n");
+            return 1;
+        }
+    }
+
+    Client client;
+    client.clear_access_channels(websocketpp::log::alevel::all);
+    client.clear_error_channels(websocketpp::log::elevel::all);
+    client.init_asio();
+    client.start_perpetual();
+
+    std::vector<std::unique_ptr<Viewer>> viewers;
+    std::string uri = fmt::format("ws://{}:{}", options.host, options.port);
+    for (int i = 0; i < options.clients; i++) {
+        auto& viewer = *viewers.emplace_back(std::make_unique<Viewer>());
+        websocketpp::lib::error_code ec;
+        auto connection = client.get_connection(uri, ec);
+        if (ec) {
+            fmt::print(stderr, "connection to {} failed: {}\n", uri, ec.message());
+            return 1;
+        }
+        connection->set_open_handler([&viewer](websocketpp::connection_hdl) { viewer.open = true; });
+        connection->set_message_handler([&client, &viewer, &options](websocketpp::connection_hdl, Client::message_ptr message) {
+            if (HandleMessage(viewer, message->get_payload()))
+                SendSettings(client, viewer, options);
+        });
+        viewer.hdl = connection->get_handle();
+        client.connect(connection);
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.threads; i++)
+        threads.emplace_back([&client]() { client.run(); });
+
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::seconds(options.duration);
+    auto inputInterval = std::chrono::duration<double>(options.inputRate > 0 ? 1 / options.inputRate : options.duration);
+    auto settingsInterval = std::chrono::duration<double>(options.settingsRate > 0 ? 1 / options.settingsRate : options.duration);
+    auto nextInput = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(inputInterval);
+    auto nextSettings = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(settingsInterval);
+    uint64_t inputs = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        auto now = std::chrono::steady_clock::now();
+        if (options.inputRate > 0 && now >= nextInput) {
+            for (auto& viewer : viewers)
+                SendInput(client, *viewer, inputs);
+            inputs++;
+            nextInput += std::chrono::duration_cast<std::chrono::steady_clock::duration>(inputInterval);
+        }
+        if (options.settingsRate > 0 && now >= nextSettings) {
+            for (auto& viewer : viewers)
+                SendSettings(client, *viewer, options);
+            nextSettings += std::chrono::duration_cast<std::chrono::steady_clock::duration>(settingsInterval);
+        }
+        std::this_thread::sleep_until(std::min({nextInput, nextSettings, end}));
+    }
+
+    client.stop_perpetual();
+    for (auto& viewer : viewers) {
+        websocketpp::lib::error_code ec;
+        client.close(viewer->hdl, websocketpp::close::status::going_away, "", ec);
+    }
+    for (auto& thread : threads)
+        thread.join();
+    running = false;
+    if (server.joinable())
+        server.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fmt::print("{} clients for {:.1f} s, times in ms as p50/p99/max\n", options.clients, seconds);
+    fmt::print(
+        "{:>6} {:>10} {:>8} {:>8} {:>8} {:>20} {:>20} {:>20}\n",
+        "client",
+        "mbps",
+        "messages",
+        "video",
+        "audio",
+        "frame gap",
+        "video latency",
+        "audio latency"
+    );
+    uint64_t totalBytes = 0;
+    int connected = 0;
+    for (size_t i = 0; i < viewers.size(); i++) {
+        auto& viewer = *viewers[i];
+        totalBytes += viewer.bytes;
+        connected += viewer.open;
+        fmt::print(
+            "{:>6} {:>10.2f} {:>8} {:>8} {:>8} {:>20} {:>20} {:>20}{}\n",
+            i,
+            viewer.bytes * 8 / seconds / 1'000'000,
+            viewer.messages,
+            viewer.videoFrames,
+            viewer.audioFrames,
+            Summary(viewer.videoGaps),
+            Summary(viewer.videoLatency),
+            Summary(viewer.audioLatency),
+            viewer.open ? "" : " (never connected)"
+        );
+    }
+    fmt::print("total {:.2f} mbps over {} connected clients\n", totalBytes * 8 / seconds / 1'000'000, connected);
+    return connected == options.clients ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+// feeds a recorded session back through audio mixing, packetizing, and the socket without the game
+// stream-replay session_123.bin [--port 3308] [--max-speed] [--viewers 1] [--no-client]
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <websocketpp/client.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+
+#include "h264.hpp"
+#include "log.hpp"
+#include "mixing.hpp"
+#include "packet.hpp"
+#include "pool.hpp"
+#include "session.hpp"
+#include "socket.hpp"
+
+using Client = websocketpp::client<websocketpp::config::asio_client>;
+
+static constexpr auto ConnectTimeout = std::chrono::seconds(30);
+// same as AudioCapture::BufferSize
+static constexpr size_t BufferSize = 1 << 17;
+
+struct Options {
+    std::string path;
+    int port = 3308;
+    bool maxSpeed = false;
+    int viewers = 0;
+    bool client = true;
+};
+
+// time spent in each stage of the replay
+struct Stage {
+    uint64_t count = 0;
+    uint64_t nanos = 0;
+};
+
+static inline uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Usage() {
+    fmt::print(
+        "usage: stream-replay <session file> [options]\n"
+        "  --port <port>      port for viewers to connect to, default 3308\n"
+        "  --max-speed        don't wait between entries\n"
+        "  --viewers <n>      wait for n other viewers to connect before starting, default 0\n"
+        "  --no-client        don't connect a loopback client to send the recorded messages\n"
+    );
+}
+
+static std::optional<Options> Parse(int argc, char** argv) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument(std::string(arg));
+                return argv[++i];
+            };
+            if (arg == "--port")
+                options.port = std::stoi(next());
+            else if (arg == "--max-speed")
+                options.maxSpeed = true;
+            else if (arg == "--viewers")
+                options.viewers = std::stoi(next());
+            else if (arg == "--no-client")
+                options.client = false;
+            else if (!arg.starts_with("--") && options.path.empty())
+                options.path = arg;
+            else
+                throw std::invalid_argument(std::string(arg));
+        }
+    } catch (std::exception const& exc) {
+        fmt::print(stderr, "invalid argument: {}\n", exc.what());
+        return std::nullopt;
+    }
+    if (options.path.empty())
+        return std::nullopt;
+    return options;
+}
+
+template <class F>
+static bool WaitFor(F&& condition) {
+    auto deadline = std::chrono::steady_clock::now() + ConnectTimeout;
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static void Quiet(Log::Level level, std::string const& message) {
+    if (level >= Log::Level::Warn)
+        fmt::print(stderr, "{}\n", message);
+}
+
+int main(int argc, char** argv) {
+    auto parsed = Parse(argc, argv);
+    if (!parsed) {
+        Usage();
+        return 1;
+    }
+    auto options = *parsed;
+    Log::SetSink(Quiet);
+
+    Session::Reader reader;
+    if (!reader.Open(options.path))
+        return 1;
+
+    Socket::Init({});
+    if (!Socket::Start(options.port))
+        return 1;
+
+    // stands in for the viewer whose messages were recorded
+    Client client;
+    std::thread clientThread;
+    std::atomic_bool clientOpen = false;
+    std::atomic<uint64_t> clientBytes = 0;
+    websocketpp::connection_hdl clientHdl;
+    if (options.client) {
+        client.clear_access_channels(websocketpp::log::alevel::all);
+        client.clear_error_channels(websocketpp::log::elevel::all);
+        client.init_asio();
+        client.set_open_handler([&clientOpen](websocketpp::connection_hdl) { clientOpen = true; });
+        client.set_message_handler([&clientBytes](websocketpp::connection_hdl, Client::message_ptr message) {
+            clientBytes += message->get_payload().size();
+        });
+        websocketpp::lib::error_code ec;
+        auto connection = client.get_connection(fmt::format("ws://127.0.0.1:{}", options.port), ec);
+        if (ec) {
+            fmt::print(stderr, "loopback client failed: {}\n", ec.message());
+            return 1;
+        }
+        clientHdl = connection->get_handle();
+        client.connect(connection);
+        clientThread = std::thread([&client]() { client.run(); });
+    }
+
+    size_t expected = options.viewers + (options.client ? 1 : 0);
+    if (expected > 0) {
+        fmt::print("waiting for {} connections on port {}\n", expected, options.port);
+        if (!WaitFor([expected]() { return Socket::GetStats().size() >= expected; })) {
+            fmt::print(stderr, "viewers didn't connect\n");
+            if (options.client) {
+                // the loopback client may not be open, so stop it outright instead of closing the connection
+                client.stop();
+                clientThread.join();
+            }
+            Socket::Stop();
+            return 1;
+        }
+    }
+
+    RingBuffer<float> gameBuffer(BufferSize);
+    RingBuffer<float> micBuffer(BufferSize);
+    std::vector<float> mixBuffer(BufferSize);
+    bool hasMic = false;
+    bool hasMicData = false;
+    H264::Assembler assembler;
+    Packet::AudioSplitter audioSplitter;
+
+    std::map<Session::Kind, uint64_t> counts;
+    uint64_t skippedUpdates = 0;
+    Stage mixing, audioPackets, videoPackets, messages;
+    std::optional<uint64_t> first;
+    uint64_t last = 0;
+    uint64_t start = Now();
+
+    while (auto entry = reader.Next()) {
+        if (!first)
+            first = entry->time;
+        last = entry->time;
+        counts[entry->kind]++;
+        // replayed timestamps keep the recorded spacing, starting from now
+        uint64_t time = start + (entry->time - *first);
+        if (!options.maxSpeed)
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(time)));
+
+        uint64_t stageStart = Now();
+        switch (entry->kind) {
+            case Session::Kind::GameAudio: {
+                auto samples = Session::AudioSamples(*entry);
+                Mixing::ScaledInsert(gameBuffer, samples.data(), samples.size(), Session::AudioVolume(*entry));
+                break;
+            }
+            case Session::Kind::MicAudio: {
+                auto samples = Session::AudioSamples(*entry);
+                float volume = Session::AudioVolume(*entry);
+                Mixing::ScaledInsert(micBuffer, samples.data(), samples.size(), volume);
+                hasMic = true;
+                hasMicData |= volume > 0;
+                break;
+            }
+            case Session::Kind::Update: {
+                // same as AudioCapture::Update, except for the limiter which only exists on the headset
+                auto update = Session::GetUpdate(*entry);
+                // a corrupt recording would otherwise divide by zero in the splitter
+                if (!update) {
+                    skippedUpdates++;
+                    break;
+                }
+                size_t gameSize = gameBuffer.Available();
+                size_t micSize = micBuffer.Available();
+                size_t size = hasMic && micSize > 0 ? std::min(gameSize, micSize) : gameSize;
+                if (size == 0)
+                    break;
+                Mixing::Read(gameBuffer, mixBuffer.data(), size);
+                if (hasMic && micSize > 0)
+                    Mixing::MixRead((Mixing::Mode) update->mixMode, micBuffer, mixBuffer.data(), size, hasMicData);
+                hasMicData = false;
+                uint64_t mixed = Now();
+                mixing.count++;
+                mixing.nanos += mixed - stageStart;
+                stageStart = mixed;
+                auto samples = std::span<float const>(mixBuffer).subspan(0, size);
+                audioSplitter.Add(samples, update->sampleRate, update->channels, update->audioPacketLength, time, Socket::SendAudioSamples);
+                audioPackets.count++;
+                audioPackets.nanos += Now() - stageStart;
+                break;
+            }
+            case Session::Kind::VideoUnit: {
+                auto unit = assembler.Add({(uint8_t const*) entry->data.data(), entry->data.size()});
+                if (!unit)
+                    break;
+                auto serialized = Pool::Acquire(unit->parameterSets.size() + unit->data.size() + Packet::MaxVideoFrameOverhead);
+                Packet::WriteVideoFrame(serialized, unit->parameterSets, unit->data, time, unit->key);
+                Socket::SendVideo(std::move(serialized), unit->key, {.capture = time, .encoded = time});
+                videoPackets.count++;
+                videoPackets.nanos += Now() - stageStart;
+                break;
+            }
+            case Session::Kind::Message: {
+                if (options.client) {
+                    websocketpp::lib::error_code ec;
+                    client.send(clientHdl, entry->data, websocketpp::frame::opcode::binary, ec);
+                }
+                messages.count++;
+                messages.nanos += Now() - stageStart;
+                break;
+            }
+        }
+    }
+
+    double elapsed = (Now() - start) / 1e9;
+    double recorded = first ? (last - *first) / 1e9 : 0;
+    // let the sender thread finish writing before reading its stats
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    fmt::print("replayed {:.2f} s of recording in {:.2f} s\n", recorded, elapsed);
+    fmt::print(
+        "entries: {} update, {} game audio, {} mic audio, {} video, {} messages\n",
+        counts[Session::Kind::Update],
+        counts[Session::Kind::GameAudio],
+        counts[Session::Kind::MicAudio],
+        counts[Session::Kind::VideoUnit],
+        counts[Session::Kind::Message]
+    );
+    if (skippedUpdates > 0)
+        fmt::print("skipped {} invalid update entries\n", skippedUpdates);
+    auto print = [](char const* name, Stage const& stage) {
+        fmt::print("{:>14}: {:>8} calls, {:>10.3f} ms total, {:>8.2f} us average\n", name, stage.count, stage.nanos / 1e6,
+                   stage.count ? stage.nanos / 1e3 / stage.count : 0);
+    };
+    print("mixing", mixing);
+    print("audio packets", audioPackets);
+    print("video packets", videoPackets);
+    print("messages", messages);
+    for (auto const& stats : Socket::GetStats())
+        fmt::print("connection {}: {} frames, {} bytes sent, {} dropped\n", stats.id, stats.sentFrames, stats.sentBytes, stats.droppedFrames);
+    if (options.client)
+        fmt::print("loopback client received {} bytes\n", clientBytes.load());
+
+    if (options.client) {
+        websocketpp::lib::error_code ec;
+        client.close(clientHdl, websocketpp::close::status::going_away, "", ec);
+        clientThread.join();
+    }
+    Socket::Stop();
+    return 0;
+}
@@ -67,7 +67,8 @@ include("${protobuf_SOURCE_DIR}/cmake/protobuf-generate.cmake")
 add_library(protos STATIC)
 add_dependencies(protos protobuf_host-build)
 
-set(PROTO_FILES_DIR "${CMAKE_CURRENT_SOURCE_DIR}/protos")
+# relative to this file so the core project can share it
+set(PROTO_FILES_DIR "${CMAKE_CURRENT_LIST_DIR}/../protos")
 file(GLOB_RECURSE PROTO_FILES "${PROTO_FILES_DIR}/*.proto")
 message(STATUS "Detected proto files: ${PROTO_FILES}")
 
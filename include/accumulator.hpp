@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "stream.pb.h"
+
+// folds input packets from the network thread into a fixed amount of state, applied once per frame
+namespace Accumulator {
+    // every key fits in 128 bits: printable keys are their uppercase ascii value, and named keys reuse control characters
+    enum Key : uint8_t {
+        None = 0,
+        Backspace = 8,
+        Enter = 13,
+        Shift = 16,
+        F2 = 17,
+        Delete = 127,
+    };
+
+    uint8_t KeyCode(std::string const& key);
+    // never touches game state, safe to call from any thread
+    void Add(Input const& input);
+    // main thread only, the cost doesn't depend on how many packets were added
+    void Apply();
+}
@@ -4,9 +4,11 @@
 #include "custom-types/shared/macros.hpp"
 #include "hollywood/shared/limiter.hpp"
 #include "mic.hpp"
+#include "ringbuffer.hpp"
 
 DECLARE_CLASS_CODEGEN(StreamMod, AudioCapture, UnityEngine::MonoBehaviour) {
     DECLARE_DEFAULT_CTOR();
+    DECLARE_DTOR(dtor);
 
     DECLARE_INSTANCE_METHOD(void, SetMicCapture, bool enabled);
     DECLARE_INSTANCE_METHOD(void, OnAudioFilterRead, ArrayW<float> data, int audioChannels);
@@ -17,15 +19,19 @@ DECLARE_CLASS_CODEGEN(StreamMod, AudioCapture, UnityEngine::MonoBehaviour) {
     DECLARE_INSTANCE_FIELD_DEFAULT(int, sampleRate, -1);
     DECLARE_INSTANCE_FIELD_DEFAULT(int, channels, -1);
     DECLARE_INSTANCE_FIELD_DEFAULT(MicCapture*, mic, nullptr);
-    DECLARE_INSTANCE_FIELD_DEFAULT(bool, hasMicData, false);
 
    public:
+    // enough for over a second of 48khz stereo
+    static constexpr size_t BufferSize = 1 << 17;
+
     std::function<void(std::span<float>, int, int)> callback;
     std::function<void(AudioCapture*)> onDisable;
 
-    std::vector<float> gameBuffer;
-    std::vector<float> micBuffer;
-    std::shared_mutex mutex;
+    // written only by the audio threads and read only by Update
+    RingBuffer<float> gameBuffer{BufferSize};
+    RingBuffer<float> micBuffer{BufferSize};
+    std::atomic_bool hasMicData = false;
+    std::vector<float> mixBuffer = std::vector<float>(BufferSize);
 
     Hollywood::SimpleLimiter limiter;
     bool initedLimiter = false;
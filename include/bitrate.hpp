@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Bitrate {
+    // restarts the controller from the configured bitrate
+    void Reset();
+    // checks connection congestion periodically, returns true when the encoder should be restarted with a new bitrate
+    bool Update();
+    // the bitrate to use for the encoder in kbps
+    int Get();
+}
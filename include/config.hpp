@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "HMUI/ViewController.hpp"
 #include "config-utils/shared/config-utils.hpp"
 
@@ -11,6 +13,38 @@ namespace Config {
     void CreateMenu(HMUI::ViewController* self, bool firstActivation, bool, bool);
     void UpdateMenu();
     void Invalidate();
+
+    // copy of the values read on hot paths, so they can be used from any thread without touching config-utils
+    struct alignas(64) Snapshot {
+        float gameVolume;
+        float micVolume;
+        float micThreshold;
+        int mixMode;
+        float smoothing;
+        int audioPacketLength;
+        bool mic;
+        bool fpfc;
+    };
+
+    // lock free, never blocks the caller
+    Snapshot GetSnapshot();
+    // publishes the loaded values and keeps the snapshot updated on every change
+    // call before anything else adds change events, so those see the new values in the snapshot too
+    void InitSnapshot();
+
+    // held while values change or are copied for saving, but not while the copy is written to disk
+    inline std::recursive_mutex SaveMutex;
+    // writes on a background thread once there have been no changes for a moment
+    void QueueSave();
+    // writes any queued changes immediately on the calling thread
+    void Flush();
+
+    template <class C, class V>
+    void SetValue(C& config, V value) {
+        std::unique_lock lock(SaveMutex);
+        config.SetValue(value, false);
+        QueueSave();
+    }
 }
 
 DECLARE_CONFIG(Config) {
@@ -19,6 +53,9 @@ DECLARE_CONFIG(Config) {
     CONFIG_VALUE(Width, int, "Resolution Width", Config::Resolutions[0].first);
     CONFIG_VALUE(Height, int, "Resolution Height", Config::Resolutions[0].second);
     CONFIG_VALUE(Bitrate, int, "Stream Bitrate", 10000, "The bitrate of the stream in kbps");
+    CONFIG_VALUE(AdaptiveBitrate, bool, "Adaptive Bitrate", false, "Whether to lower the bitrate automatically when viewers fall behind");
+    CONFIG_VALUE(MinBitrate, int, "Minimum Bitrate", 2000, "The lowest bitrate the adaptive bitrate can choose in kbps");
+    CONFIG_VALUE(MaxBitrate, int, "Maximum Bitrate", 20000, "The highest bitrate the adaptive bitrate can choose in kbps");
     CONFIG_VALUE(FPS, float, "Stream FPS", 30, "The frames per second of the stream");
     CONFIG_VALUE(FOV, float, "Stream FOV", 80, "The fov of the stream camera");
 
@@ -32,4 +69,5 @@ DECLARE_CONFIG(Config) {
     CONFIG_VALUE(MicVolume, float, "Microphone Volume", 1, "The volume level of the microphone audio");
     CONFIG_VALUE(MicThreshold, float, "Microphone Threshold", 1, "At what loudness should noises from the microphone be heard");
     CONFIG_VALUE(MixMode, int, "Mixing Mode", 1, "How to combine the microphone audio with the game audio");
+    CONFIG_VALUE(AudioPacketLength, int, "Audio Packet Length", 10, "The duration of each audio packet in milliseconds");
 };
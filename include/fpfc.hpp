@@ -9,8 +9,11 @@ namespace FPFC {
     void GetControllers();
     void ReleaseControllers();
     void OnSceneChange();
-    void KeyDown(std::string const& key);
-    void KeyUp(std::string const& key);
+    // key codes from Accumulator::KeyCode
+    void KeyDown(uint8_t key);
+    void KeyUp(uint8_t key);
+    // for the in game keyboard, with \b for deleting and \n for confirming
+    void Type(char character);
     void MouseMove(UnityEngine::Vector2 move);
     void MouseDown();
     void MouseUp();
@@ -11,7 +11,9 @@ namespace Manager {
     void Invalidate();
     void SetCamera(UnityEngine::Camera* main);
     void HandleMessage(PacketWrapper const& packet, void* source);
-    void UpdateSettings(void* source = nullptr);
+    // restart is only needed for settings that affect the video encoder
+    void UpdateSettings(void* source = nullptr, bool restart = true);
+    void AddViewer(void* connection);
     bool IsCapturing();
     void RestartCapture();
     void StopCapture();
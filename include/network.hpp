@@ -2,12 +2,10 @@
 
 #include <functional>
 
-#include "stream.pb.h"
-
-namespace Socket {
+// connects the engine independent socket to the rest of the mod
+namespace Network {
     void Init();
-    bool Start();
-    void Stop(std::function<void()> stopped = nullptr);
+    // restarts the server on the configured port
     void Refresh(std::function<void(bool)> done = nullptr);
-    void Send(PacketWrapper const& packet, void* exclude = nullptr);
+    void Stop(std::function<void()> stopped = nullptr);
 }
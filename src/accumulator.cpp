@@ -0,0 +1,165 @@
+#include "accumulator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+
+#include "config.hpp"
+#include "fpfc.hpp"
+#include "queue.hpp"
+
+using Mask = std::array<std::atomic<uint64_t>, 2>;
+
+static std::atomic<float> moveX = 0;
+static std::atomic<float> moveY = 0;
+static std::atomic<float> scroll = 0;
+static std::atomic_bool mouseHeld = false;
+static std::atomic_bool mousePressed = false;
+static std::atomic_bool mouseReleased = false;
+// current state of each key and whether it went down or up since the last frame
+static Mask keysHeld;
+static Mask keysPressed;
+static Mask keysReleased;
+// text for the in game keyboard, which needs every character in order
+static MpscQueue<char> typed;
+
+static void AtomicAdd(std::atomic<float>& value, float amount) {
+    float current = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(current, current + amount, std::memory_order_relaxed))
+        ;
+}
+
+static void SetBit(Mask& mask, uint8_t key) {
+    mask[key / 64].fetch_or(uint64_t(1) << (key % 64), std::memory_order_relaxed);
+}
+
+static void ClearBit(Mask& mask, uint8_t key) {
+    mask[key / 64].fetch_and(~(uint64_t(1) << (key % 64)), std::memory_order_relaxed);
+}
+
+static void AddMasks(std::array<uint64_t, 2> down, std::array<uint64_t, 2> up) {
+    for (int i = 0; i < 2; i++) {
+        if (down[i]) {
+            keysHeld[i].fetch_or(down[i], std::memory_order_relaxed);
+            keysPressed[i].fetch_or(down[i], std::memory_order_relaxed);
+        }
+        if (up[i]) {
+            keysHeld[i].fetch_and(~up[i], std::memory_order_relaxed);
+            keysReleased[i].fetch_or(up[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+// the 32 bit words from the network in the same layout as a Mask
+static std::array<uint64_t, 2> Words(google::protobuf::RepeatedField<uint32_t> const& words) {
+    std::array<uint64_t, 2> ret = {};
+    for (int i = 0; i < std::min(words.size(), 4); i++)
+        ret[i / 2] |= uint64_t(words[i]) << (32 * (i % 2));
+    return ret;
+}
+
+template <class F>
+static void ForEachBit(uint64_t bits, int offset, F&& func) {
+    while (bits) {
+        func(offset + std::countr_zero(bits));
+        bits &= bits - 1;
+    }
+}
+
+uint8_t Accumulator::KeyCode(std::string const& key) {
+    if (key.size() == 1) {
+        auto upper = toupper((unsigned char) key[0]);
+        return upper < 128 ? upper : None;
+    }
+    if (key == "Backspace")
+        return Backspace;
+    if (key == "Enter")
+        return Enter;
+    if (key == "Shift")
+        return Shift;
+    if (key == "F2")
+        return F2;
+    if (key == "Delete")
+        return Delete;
+    return None;
+}
+
+void Accumulator::Add(Input const& input) {
+    if (input.dx() != 0)
+        AtomicAdd(moveX, input.dx());
+    if (input.dy() != 0)
+        AtomicAdd(moveY, input.dy());
+    if (input.scroll() != 0)
+        AtomicAdd(scroll, input.scroll());
+    if (input.mousedown()) {
+        mouseHeld = true;
+        mousePressed = true;
+    }
+    if (input.mouseup()) {
+        mouseHeld = false;
+        mouseReleased = true;
+    }
+    AddMasks(Words(input.keysdownmask()), Words(input.keysupmask()));
+    for (char character : input.text())
+        typed.Push(character);
+    // string keys from older clients
+    for (auto& key : input.keysdown()) {
+        uint8_t code = KeyCode(key);
+        if (key.size() == 1)
+            typed.Push(key[0]);
+        else if (code == Backspace || code == Delete)
+            typed.Push('\b');
+        else if (code == Enter)
+            typed.Push('\n');
+        if (code == None)
+            continue;
+        SetBit(keysHeld, code);
+        SetBit(keysPressed, code);
+    }
+    for (auto& key : input.keysup()) {
+        uint8_t code = KeyCode(key);
+        if (code == None)
+            continue;
+        ClearBit(keysHeld, code);
+        SetBit(keysReleased, code);
+    }
+}
+
+void Accumulator::Apply() {
+    float dx = moveX.exchange(0);
+    float dy = moveY.exchange(0);
+    float scrolled = scroll.exchange(0);
+    std::array<uint64_t, 2> pressed, released, held;
+    for (int i = 0; i < 2; i++) {
+        pressed[i] = keysPressed[i].exchange(0);
+        released[i] = keysReleased[i].exchange(0);
+        held[i] = keysHeld[i].load();
+    }
+
+    bool fpfc = Config::GetSnapshot().fpfc;
+    while (auto character = typed.Pop()) {
+        if (fpfc)
+            FPFC::Type(*character);
+    }
+    if (!fpfc) {
+        mousePressed = false;
+        mouseReleased = false;
+        return;
+    }
+
+    if (dx != 0 || dy != 0)
+        FPFC::MouseMove({dx, dy});
+    if (scrolled != 0)
+        FPFC::AddScroll(scrolled);
+    // a release is left for the next frame, so that clicks shorter than a frame still register
+    if (mousePressed.exchange(false))
+        FPFC::MouseDown();
+    else if (mouseReleased.exchange(false) && !mouseHeld)
+        FPFC::MouseUp();
+    for (int i = 0; i < 2; i++) {
+        ForEachBit(pressed[i], i * 64, [](uint8_t key) { FPFC::KeyDown(key); });
+        // keys that were released and pressed again are still held
+        ForEachBit(released[i] & ~held[i], i * 64, [](uint8_t key) { FPFC::KeyUp(key); });
+    }
+}
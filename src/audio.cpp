@@ -4,20 +4,16 @@
 #include "UnityEngine/GameObject.hpp"
 #include "config.hpp"
 #include "main.hpp"
+#include "metrics.hpp"
 #include "mic.hpp"
+#include "mixing.hpp"
+#include "session.hpp"
+#include "trace.hpp"
 
 DEFINE_TYPE(StreamMod, AudioCapture);
 
 using namespace StreamMod;
 
-template <class T>
-static void ScaledInsert(T& mutex, std::vector<float>& buffer, ArrayW<float>& data, float volume) {
-    std::shared_lock lock(mutex);
-    buffer.reserve(buffer.size() + data.size());
-    for (float sample : data)
-        buffer.emplace_back(sample * volume);
-}
-
 void AudioCapture::SetMicCapture(bool enabled) {
     logger.debug("set mic {}", enabled);
     if (enabled) {
@@ -26,13 +22,16 @@ void AudioCapture::SetMicCapture(bool enabled) {
             mic->callback = [this](ArrayW<float> data) {
                 if (channels == -1 || sampleRate == -1)
                     return;
-                bool overThreshold = mic->currentLoudness >= getConfig().MicThreshold.GetValue();
+                auto config = Config::GetSnapshot();
+                bool overThreshold = mic->currentLoudness >= config.micThreshold;
                 if (overThreshold)
                     hasMicData = true;
                 // not sure why it's so quiet that I have to multiply it by 10
                 // audioSource volume doesn't seem to matter, at least above 1
-                float volume = overThreshold ? getConfig().MicVolume.GetValue() * 10 : 0;
-                ScaledInsert(mutex, micBuffer, data, volume);
+                float volume = overThreshold ? config.micVolume * 10 : 0;
+                if (Session::recording)
+                    Session::RecordAudio(Session::Kind::MicAudio, Trace::Now(), volume, {data.begin(), data.size()});
+                Mixing::ScaledInsert(micBuffer, data.begin(), data.size(), volume);
             };
         }
         mic->Init();
@@ -41,28 +40,41 @@ void AudioCapture::SetMicCapture(bool enabled) {
 }
 
 void AudioCapture::OnAudioFilterRead(ArrayW<float> data, int audioChannels) {
+    TRACE_SCOPE("AudioCapture::OnAudioFilterRead");
     channels = audioChannels;
     if (sampleRate == -1)
         return;  // can't get it on this thread
-    ScaledInsert(mutex, gameBuffer, data, getConfig().GameVolume.GetValue());
+    float volume = Config::GetSnapshot().gameVolume;
+    if (Session::recording)
+        Session::RecordAudio(Session::Kind::GameAudio, Trace::Now(), volume, {data.begin(), data.size()});
+    Mixing::ScaledInsert(gameBuffer, data.begin(), data.size(), volume);
 }
 
 void AudioCapture::Update() {
+    TRACE_SCOPE("AudioCapture::Update");
     if (sampleRate == -1)
         sampleRate = UnityEngine::AudioSettings::get_outputSampleRate();
     if (channels == -1 || sampleRate == -1)
         return;
-    if (!initedLimiter)
+    if (!initedLimiter) {
         limiter.init(channels, sampleRate);
+        initedLimiter = true;
+    }
+    if (Session::recording) {
+        auto config = Config::GetSnapshot();
+        Session::RecordUpdate(Trace::Now(), {sampleRate, channels, config.mixMode, config.audioPacketLength});
+    }
 
-    std::unique_lock lock(mutex);
+    size_t gameSize = gameBuffer.Available();
+    size_t micSize = micBuffer.Available();
+    Metrics::GameBufferFill.Set(gameSize / (double) gameBuffer.Capacity());
+    Metrics::MicBufferFill.Set(micSize / (double) micBuffer.Capacity());
 
-    if (!mic || micBuffer.empty()) {
-        if (!gameBuffer.empty()) {
-            for (auto& data : gameBuffer)
-                data = limiter.process(data);
-            callback(gameBuffer, sampleRate, channels);
-            gameBuffer.clear();
+    if (!mic || micSize == 0) {
+        if (gameSize > 0) {
+            Mixing::Read(gameBuffer, mixBuffer.data(), gameSize);
+            Mixing::Limit(limiter, mixBuffer.data(), gameSize);
+            callback(std::span(mixBuffer).subspan(0, gameSize), sampleRate, channels);
         }
         return;
     }
@@ -70,25 +82,13 @@ void AudioCapture::Update() {
     if (mic->channels != -1 && mic->sampleRate != -1 && (mic->channels != channels || mic->sampleRate != sampleRate))
         logger.warn("mismatch in reported config! mic: {}/{}, game: {}/{}", mic->channels, mic->sampleRate, channels, sampleRate);
 
-    int size = std::min(gameBuffer.size(), micBuffer.size());
+    size_t size = std::min(gameSize, micSize);
+    Mixing::Read(gameBuffer, mixBuffer.data(), size);
 
-    switch (getConfig().MixMode.GetValue()) {
-        case 1:
-            if (!hasMicData)
-                break;
-        case 0:
-            for (int i = 0; i < size; i++)
-                gameBuffer[i] = limiter.process((gameBuffer[i] + micBuffer[i]) / 2);
-            break;
-        default:
-            for (int i = 0; i < size; i++)
-                gameBuffer[i] = limiter.process(gameBuffer[i] + micBuffer[i]);
-            break;
-    }
-    callback(std::span(gameBuffer).subspan(0, size), sampleRate, channels);
+    Mixing::MixRead((Mixing::Mode) Config::GetSnapshot().mixMode, micBuffer, mixBuffer.data(), size, hasMicData);
+    Mixing::Limit(limiter, mixBuffer.data(), size);
+    callback(std::span(mixBuffer).subspan(0, size), sampleRate, channels);
 
-    gameBuffer.erase(gameBuffer.begin(), gameBuffer.begin() + size);
-    micBuffer.erase(micBuffer.begin(), micBuffer.begin() + size);
     hasMicData = false;
 }
 
@@ -102,3 +102,8 @@ void AudioCapture::OnDestroy() {
         mic->callback = nullptr;
     mic = nullptr;
 }
+
+// il2cpp frees the object without running c++ destructors, which would leak the buffers
+void AudioCapture::dtor() {
+    this->~AudioCapture();
+}
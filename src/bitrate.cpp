@@ -0,0 +1,155 @@
+#include "bitrate.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <map>
+
+#include "config.hpp"
+#include "main.hpp"
+#include "socket.hpp"
+
+using clock_type = std::chrono::steady_clock;
+
+static constexpr auto CheckInterval = std::chrono::seconds(1);
+// a restart produces a burst of key frame data, so wait before judging the new bitrate
+static constexpr auto SettleTime = std::chrono::seconds(3);
+// increases are slower and less frequent than decreases
+static constexpr auto IncreaseCooldown = std::chrono::seconds(20);
+static constexpr int StableChecks = 5;
+static constexpr float DecreaseFactor = 0.7;
+static constexpr float IncreaseFactor = 1.15;
+// changes smaller than this are not worth an encoder restart
+static constexpr float MinChange = 0.1;
+// every restart stalls all viewers until the next key frame, so there are at most this many in the window
+// no matter how many connections report congestion, kept across resets
+static constexpr size_t MaxRestarts = 3;
+static constexpr auto RestartWindow = std::chrono::seconds(60);
+
+static constexpr size_t CongestedQueueBytes = 512 * 1024;
+static constexpr uint32_t CongestedDecodeQueue = 10;
+static constexpr float CongestedLatency = 0.5;
+
+struct Previous {
+    uint64_t droppedFrames;
+    size_t queuedBytes;
+};
+
+static int applied = -1;
+static float target = -1;
+static int stableChecks = 0;
+static clock_type::time_point lastCheck;
+static clock_type::time_point lastApplied;
+static std::map<void*, Previous> previous;
+// times of the last adaptive restarts, the oldest one at nextRestart
+static std::array<clock_type::time_point, MaxRestarts> restarts;
+static size_t nextRestart = 0;
+
+static int Clamp(float value) {
+    int min = getConfig().MinBitrate.GetValue();
+    int max = std::max(min, getConfig().MaxBitrate.GetValue());
+    return std::clamp((int) std::lround(value), min, max);
+}
+
+static bool Congested() {
+    bool congested = false;
+    std::map<void*, Previous> current;
+    for (auto const& stats : Socket::GetStats()) {
+        current[stats.id] = {stats.droppedFrames, stats.queuedBytes};
+        auto found = previous.find(stats.id);
+        // new connections always have a full key frame queued
+        if (found == previous.end())
+            continue;
+        bool dropped = stats.droppedFrames > found->second.droppedFrames;
+        bool growing = stats.queuedBytes > found->second.queuedBytes && found->second.queuedBytes > 0;
+        if (dropped || growing || stats.queuedBytes > CongestedQueueBytes || stats.decodeQueue > CongestedDecodeQueue ||
+            stats.latency > CongestedLatency) {
+            logger.debug(
+                "connection {} congested, dropped {} queued {} decode queue {} latency {}",
+                stats.id,
+                dropped,
+                stats.queuedBytes,
+                stats.decodeQueue,
+                stats.latency
+            );
+            congested = true;
+        }
+    }
+    previous = std::move(current);
+    return congested;
+}
+
+static bool RestartsFull(clock_type::time_point now) {
+    return now - restarts[nextRestart] < RestartWindow;
+}
+
+static void RecordRestart(clock_type::time_point now) {
+    restarts[nextRestart] = now;
+    nextRestart = (nextRestart + 1) % MaxRestarts;
+    previous.clear();
+}
+
+void Bitrate::Reset() {
+    applied = -1;
+    target = -1;
+    stableChecks = 0;
+    previous.clear();
+}
+
+bool Bitrate::Update() {
+    if (!getConfig().AdaptiveBitrate.GetValue())
+        return false;
+
+    auto now = clock_type::now();
+    if (now - lastCheck < CheckInterval)
+        return false;
+    lastCheck = now;
+
+    if (applied < 0) {
+        // the encoder is still using the configured bitrate
+        applied = getConfig().Bitrate.GetValue();
+        target = applied;
+        lastApplied = now;
+        // moving it into the limits is a restart like any other, and is left to the loop below when the window is full
+        int clamped = Clamp(applied);
+        if (clamped == applied || RestartsFull(now))
+            return false;
+        applied = clamped;
+        target = clamped;
+        RecordRestart(now);
+        return true;
+    }
+    if (now - lastApplied < SettleTime) {
+        previous.clear();
+        return false;
+    }
+    // the target would only keep dropping without being applied
+    if (RestartsFull(now)) {
+        previous.clear();
+        return false;
+    }
+
+    if (Congested()) {
+        target = std::min(target, (float) applied) * DecreaseFactor;
+        stableChecks = 0;
+    } else if (++stableChecks >= StableChecks && now - lastApplied >= IncreaseCooldown) {
+        target = std::max(target, (float) applied) * IncreaseFactor;
+        stableChecks = 0;
+    }
+    target = Clamp(target);
+
+    if (std::abs(target - applied) < applied * MinChange)
+        return false;
+    logger.info("adapting bitrate from {} to {} kbps", applied, (int) target);
+    applied = target;
+    lastApplied = now;
+    RecordRestart(now);
+    return true;
+}
+
+int Bitrate::Get() {
+    if (!getConfig().AdaptiveBitrate.GetValue() || applied < 0)
+        return getConfig().Bitrate.GetValue();
+    return applied;
+}
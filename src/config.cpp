@@ -1,15 +1,173 @@
 #include "config.hpp"
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <thread>
+
+#include "main.hpp"
+
+// wait for changes to stop before saving, unless they have been happening for too long
+static constexpr auto SaveDelay = std::chrono::seconds(1);
+static constexpr auto MaxSaveDelay = std::chrono::seconds(5);
+
+static std::mutex saveStateMutex;
+static std::condition_variable saveSignal;
+static bool saveThreadStarted = false;
+static bool dirty = false;
+static std::chrono::steady_clock::time_point firstChange;
+static std::chrono::steady_clock::time_point lastChange;
+
+// saves go through a copy, so the slow write doesn't hold the lock that changes on the main thread wait for
+static std::mutex saveWriteMutex;
+static Config_t saved;
+static bool savedInitialized = false;
+
+// seqlock, the sequence is odd while the single writer is updating the words
+static constexpr size_t SnapshotWords = sizeof(Config::Snapshot) / sizeof(uint32_t);
+alignas(64) static std::atomic<uint32_t> snapshotSequence = 0;
+alignas(64) static std::array<std::atomic<uint32_t>, SnapshotWords> snapshotWords;
+
+// keep in sync with DECLARE_CONFIG in config.hpp
+static void CopyValues(Config_t& to, Config_t& from) {
+    auto copy = [](auto& to, auto& from) { to.SetValue(from.GetValue(), false); };
+    copy(to.Port, from.Port);
+    copy(to.Width, from.Width);
+    copy(to.Height, from.Height);
+    copy(to.Bitrate, from.Bitrate);
+    copy(to.AdaptiveBitrate, from.AdaptiveBitrate);
+    copy(to.MinBitrate, from.MinBitrate);
+    copy(to.MaxBitrate, from.MaxBitrate);
+    copy(to.FPS, from.FPS);
+    copy(to.FOV, from.FOV);
+    copy(to.FPFC, from.FPFC);
+    copy(to.Smoothing, from.Smoothing);
+    copy(to.Mic, from.Mic);
+    copy(to.GameVolume, from.GameVolume);
+    copy(to.MicVolume, from.MicVolume);
+    copy(to.MicThreshold, from.MicThreshold);
+    copy(to.MixMode, from.MixMode);
+    copy(to.AudioPacketLength, from.AudioPacketLength);
+}
+
+static void SaveNow() {
+    std::unique_lock writing(saveWriteMutex);
+    if (!savedInitialized) {
+        saved.Init({MOD_ID, VERSION, 0});
+        savedInitialized = true;
+    }
+    {
+        std::unique_lock lock(Config::SaveMutex);
+        {
+            std::unique_lock state(saveStateMutex);
+            if (!dirty)
+                return;
+            dirty = false;
+        }
+        CopyValues(saved, getConfig());
+    }
+    saved.Save();
+}
+
+static std::chrono::steady_clock::time_point SaveDeadline() {
+    return std::min(lastChange + SaveDelay, firstChange + MaxSaveDelay);
+}
+
+static void SaveThread() {
+    std::unique_lock lock(saveStateMutex);
+    while (true) {
+        saveSignal.wait(lock, []() { return dirty; });
+        // new changes move the deadline, so check it again after waking
+        if (saveSignal.wait_until(lock, SaveDeadline(), []() { return !dirty; }) || std::chrono::steady_clock::now() < SaveDeadline())
+            continue;
+        lock.unlock();
+        SaveNow();
+        lock.lock();
+    }
+}
+
+void Config::QueueSave() {
+    std::unique_lock lock(saveStateMutex);
+    auto now = std::chrono::steady_clock::now();
+    if (!dirty)
+        firstChange = now;
+    lastChange = now;
+    dirty = true;
+    if (!saveThreadStarted) {
+        std::thread(SaveThread).detach();
+        saveThreadStarted = true;
+    }
+    saveSignal.notify_one();
+}
+
+void Config::Flush() {
+    SaveNow();
+}
+
+Config::Snapshot Config::GetSnapshot() {
+    std::array<uint32_t, SnapshotWords> words;
+    uint32_t before, after;
+    do {
+        before = snapshotSequence.load(std::memory_order_acquire);
+        for (size_t i = 0; i < SnapshotWords; i++)
+            words[i] = snapshotWords[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = snapshotSequence.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1));
+    Snapshot ret;
+    std::memcpy(&ret, words.data(), sizeof(Snapshot));
+    return ret;
+}
+
+// main thread only
+static void PublishSnapshot() {
+    Config::Snapshot snapshot = {
+        .gameVolume = getConfig().GameVolume.GetValue(),
+        .micVolume = getConfig().MicVolume.GetValue(),
+        .micThreshold = getConfig().MicThreshold.GetValue(),
+        .mixMode = getConfig().MixMode.GetValue(),
+        .smoothing = getConfig().Smoothing.GetValue(),
+        .audioPacketLength = getConfig().AudioPacketLength.GetValue(),
+        .mic = getConfig().Mic.GetValue(),
+        .fpfc = getConfig().FPFC.GetValue(),
+    };
+    std::array<uint32_t, SnapshotWords> words = {};
+    std::memcpy(words.data(), &snapshot, sizeof(Config::Snapshot));
+
+    uint32_t sequence = snapshotSequence.load(std::memory_order_relaxed);
+    snapshotSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < SnapshotWords; i++)
+        snapshotWords[i].store(words[i], std::memory_order_relaxed);
+    snapshotSequence.store(sequence + 2, std::memory_order_release);
+}
+
+void Config::InitSnapshot() {
+    // change events run in the order they were added, so these come before any that read the snapshot
+    auto publish = [](auto) { PublishSnapshot(); };
+    getConfig().GameVolume.AddChangeEvent(publish);
+    getConfig().MicVolume.AddChangeEvent(publish);
+    getConfig().MicThreshold.AddChangeEvent(publish);
+    getConfig().MixMode.AddChangeEvent(publish);
+    getConfig().Smoothing.AddChangeEvent(publish);
+    getConfig().AudioPacketLength.AddChangeEvent(publish);
+    getConfig().Mic.AddChangeEvent(publish);
+    getConfig().FPFC.AddChangeEvent(publish);
+    PublishSnapshot();
+}
+
 #if __has_include("bsml/shared/BSML.hpp")
 #include "System/Net/Dns.hpp"
 #include "System/Net/IPAddress.hpp"
 #include "System/Net/IPHostEntry.hpp"
 #include "System/Net/Sockets/AddressFamily.hpp"
 #include "bsml/shared/BSML-Lite.hpp"
-#include "main.hpp"
 #include "manager.hpp"
 #include "metacore/shared/ui.hpp"
-#include "socket.hpp"
+#include "network.hpp"
+#include "session.hpp"
+#include "trace.hpp"
 
 static BSML::IncrementSetting* CreateEnumIncrement(
     const BSML::Lite::TransformWrapper& parent,
@@ -54,6 +212,7 @@ static TMPro::TextMeshProUGUI* ip;
 static HMUI::InputFieldView* port;
 static BSML::IncrementSetting* resolution;
 static BSML::SliderSetting* bitrate;
+static BSML::ToggleSetting* adaptiveBitrate;
 static BSML::SliderSetting* fps;
 static BSML::SliderSetting* fov;
 static BSML::SliderSetting* smoothness;
@@ -62,6 +221,8 @@ static BSML::SliderSetting* gameVolume;
 static BSML::SliderSetting* micVolume;
 static BSML::SliderSetting* micThreshold;
 static BSML::IncrementSetting* mixMode;
+static BSML::ToggleSetting* trace;
+static BSML::ToggleSetting* session;
 
 void Config::CreateMenu(HMUI::ViewController* self, bool firstActivation, bool, bool) {
     if (!firstActivation) {
@@ -88,70 +249,94 @@ void Config::CreateMenu(HMUI::ViewController* self, bool firstActivation, bool,
             return;
         }
 
-        getConfig().Port.SetValue(str);
-        Socket::Refresh();
+        Config::SetValue(getConfig().Port, str);
+        Network::Refresh();
     });
 
     resolution = CreateEnumIncrement(settings, "Resolution", ResolutionStrings, 0, [](int value) {
         if (value >= Resolutions.size())
             return;
         auto const& [width, height] = Resolutions[value];
-        getConfig().Width.SetValue(width);
-        getConfig().Height.SetValue(height);
+        Config::SetValue(getConfig().Width, width);
+        Config::SetValue(getConfig().Height, height);
         Manager::UpdateSettings();
     });
 
     bitrate =
         BSML::Lite::CreateSliderSetting(settings, "Bitrate", 1000, getConfig().Bitrate.GetValue(), 1000, 20000, 0.5, true, {0, 0}, [](float value) {
-            getConfig().Bitrate.SetValue(value);
+            Config::SetValue(getConfig().Bitrate, value);
             Manager::UpdateSettings();
         });
     bitrate->formatter = [](float value) {
         return fmt::format("{} kbps", (int) value);
     };
 
+    adaptiveBitrate = BSML::Lite::CreateToggle(settings, "Adaptive Bitrate", getConfig().AdaptiveBitrate.GetValue(), [](bool value) {
+        Config::SetValue(getConfig().AdaptiveBitrate, value);
+        Manager::UpdateSettings();
+    });
+    BSML::Lite::AddHoverHint(
+        adaptiveBitrate->gameObject, "Lowers the bitrate when viewers fall behind. Each change restarts the encoder, pausing the stream briefly"
+    );
+
     fps = BSML::Lite::CreateSliderSetting(settings, "FPS", 5, getConfig().FPS.GetValue(), 10, 90, 0.5, true, {0, 0}, [](float value) {
-        getConfig().FPS.SetValue(value);
+        Config::SetValue(getConfig().FPS, value);
         Manager::UpdateSettings();
     });
 
     fov = BSML::Lite::CreateSliderSetting(settings, "FOV", 1, getConfig().FOV.GetValue(), 50, 100, 0.5, true, {0, 0}, [](float value) {
-        getConfig().FOV.SetValue(value);
+        Config::SetValue(getConfig().FOV, value);
         Manager::UpdateSettings();
     });
 
     smoothness =
         BSML::Lite::CreateSliderSetting(settings, "Smoothness", 0.1, getConfig().Smoothing.GetValue(), 0, 2, 0.5, true, {0, 0}, [](float value) {
-            getConfig().Smoothing.SetValue(value);
-            Manager::UpdateSettings();
+            Config::SetValue(getConfig().Smoothing, value);
+            Manager::UpdateSettings(nullptr, false);
         });
 
     mic = BSML::Lite::CreateToggle(settings, "Enable Mic", getConfig().Mic.GetValue(), [](bool value) {
-        getConfig().Mic.SetValue(value);
-        Manager::UpdateSettings();
+        Config::SetValue(getConfig().Mic, value);
+        Manager::UpdateSettings(nullptr, false);
     });
 
     gameVolume =
         BSML::Lite::CreateSliderSetting(settings, "Game Volume", 0.1, getConfig().GameVolume.GetValue(), 0, 2, 0.5, true, {0, 0}, [](float value) {
-            getConfig().GameVolume.SetValue(value);
-            Manager::UpdateSettings();
+            Config::SetValue(getConfig().GameVolume, value);
+            Manager::UpdateSettings(nullptr, false);
         });
 
     micVolume =
         BSML::Lite::CreateSliderSetting(settings, "Mic Volume", 0.1, getConfig().MicVolume.GetValue(), 0, 2, 0.5, true, {0, 0}, [](float value) {
-            getConfig().MicVolume.SetValue(value);
-            Manager::UpdateSettings();
+            Config::SetValue(getConfig().MicVolume, value);
+            Manager::UpdateSettings(nullptr, false);
         });
 
     micThreshold =
         BSML::Lite::CreateSliderSetting(settings, "Mic Threshold", 0.1, getConfig().MicThreshold.GetValue(), 0, 2, 0.5, true, {0, 0}, [](float value) {
-            getConfig().MicThreshold.SetValue(value);
-            Manager::UpdateSettings();
+            Config::SetValue(getConfig().MicThreshold, value);
+            Manager::UpdateSettings(nullptr, false);
         });
 
     mixMode = CreateEnumIncrement(settings, "Mic Mixing", MixModeStrings, 0, [](int value) {
-        getConfig().MixMode.SetValue(value);
-        Manager::UpdateSettings();
+        Config::SetValue(getConfig().MixMode, value);
+        Manager::UpdateSettings(nullptr, false);
+    });
+
+    // not saved, only for diagnosing performance
+    trace = BSML::Lite::CreateToggle(settings, "Record Trace", Trace::enabled, [](bool value) {
+        if (value)
+            Trace::Start();
+        else
+            Trace::Stop();
+    });
+
+    // not saved, records audio, encoder output, and messages for replaying on a pc
+    session = BSML::Lite::CreateToggle(settings, "Record Session", Session::recording, [](bool value) {
+        if (value)
+            Session::Start();
+        else
+            Session::Stop();
     });
 
     init = true;
@@ -178,6 +363,7 @@ void Config::UpdateMenu() {
     SetEnumIncrement(resolution, ResolutionStrings, idx, "Custom");
 
     bitrate->set_Value(getConfig().Bitrate.GetValue());
+    MetaCore::UI::InstantSetToggle(adaptiveBitrate, getConfig().AdaptiveBitrate.GetValue());
     fps->set_Value(getConfig().FPS.GetValue());
     fov->set_Value(getConfig().FOV.GetValue());
     smoothness->set_Value(getConfig().Smoothing.GetValue());
@@ -186,13 +372,18 @@ void Config::UpdateMenu() {
     micVolume->set_Value(getConfig().MicVolume.GetValue());
     micThreshold->set_Value(getConfig().MicThreshold.GetValue());
     SetEnumIncrement(mixMode, MixModeStrings, getConfig().MixMode.GetValue(), "Invalid");
+    MetaCore::UI::InstantSetToggle(trace, Trace::enabled);
+    MetaCore::UI::InstantSetToggle(session, Session::recording);
 }
 
 void Config::Invalidate() {
+    Flush();
     init = false;
 }
 #else
 void Config::CreateMenu(HMUI::ViewController* self, bool firstActivation, bool, bool) {}
 void Config::UpdateMenu() {}
-void Config::Invalidate() {}
+void Config::Invalidate() {
+    Flush();
+}
 #endif
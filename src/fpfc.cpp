@@ -1,5 +1,7 @@
 #include "fpfc.hpp"
 
+#include <array>
+
 #include "GlobalNamespace/FirstPersonFlyingController.hpp"
 #include "GlobalNamespace/OculusVRHelper.hpp"
 #include "GlobalNamespace/PauseController.hpp"
@@ -19,6 +21,7 @@
 #include "VRUIControls/MouseButtonEventData.hpp"
 #include "VRUIControls/MouseState.hpp"
 #include "VRUIControls/VRInputModule.hpp"
+#include "accumulator.hpp"
 #include "config.hpp"
 #include "hooks.hpp"
 #include "main.hpp"
@@ -39,7 +42,7 @@ static UnityEngine::Quaternion rotation;
 static HMUI::UIKeyboard* keyboardOpen;
 
 static inline bool CapturingFPFC() {
-    return Manager::IsCapturing() && getConfig().FPFC.GetValue();
+    return Manager::IsCapturing() && Config::GetSnapshot().fpfc;
 }
 
 static GameObject* GetPauseMenu() {
@@ -111,76 +114,95 @@ void FPFC::OnSceneChange() {
     GetControllers();
 }
 
-void FPFC::KeyDown(std::string const& key) {
-    if (keyboardOpen) {
-        if (key == "Backspace" || key == "Delete")
-            keyboardOpen->deleteButtonWasPressedEvent->Invoke();
-        else if (key == "Enter")
-            keyboardOpen->okButtonWasPressedEvent->Invoke();
-        else if (key.size() == 1)
-            keyboardOpen->keyWasPressedEvent->Invoke(key[0]);
-        return;
+enum class Action : uint8_t { None, Refresh, Pause, Restart, Menu, Continue, Forward, Right, Up, Back, Left, Down };
+
+// indexed by key code, so dispatch is a single lookup
+static constexpr auto KeyActions = []() {
+    std::array<Action, 128> ret = {};
+    ret[Accumulator::F2] = Action::Refresh;
+    ret['P'] = Action::Pause;
+    ret['R'] = Action::Restart;
+    ret['M'] = Action::Menu;
+    ret['C'] = Action::Continue;
+    ret['W'] = Action::Forward;
+    ret['D'] = Action::Right;
+    ret['E'] = Action::Up;
+    ret[' '] = Action::Up;
+    ret['S'] = Action::Back;
+    ret['A'] = Action::Left;
+    ret['Q'] = Action::Down;
+    ret[Accumulator::Shift] = Action::Down;
+    return ret;
+}();
+
+static float* MovementAxis(Action action) {
+    switch (action) {
+        case Action::Forward:
+            return &movementF.z;
+        case Action::Right:
+            return &movementF.x;
+        case Action::Up:
+            return &movementF.y;
+        case Action::Back:
+            return &movementB.z;
+        case Action::Left:
+            return &movementB.x;
+        case Action::Down:
+            return &movementB.y;
+        default:
+            return nullptr;
     }
-    if (key == "F2") {
-        GetControllers();
+}
+
+void FPFC::KeyDown(uint8_t key) {
+    if (keyboardOpen)
         return;
+    auto action = KeyActions[key & 127];
+    switch (action) {
+        case Action::Refresh:
+            GetControllers();
+            break;
+        case Action::Pause:
+            if (auto pauser = Object::FindObjectOfType<PauseController*>())
+                pauser->Pause();
+            break;
+        case Action::Restart:
+            if (auto pauser = Object::FindObjectOfType<PauseMenuManager*>())
+                pauser->RestartButtonPressed();
+            break;
+        case Action::Menu:
+            if (auto pauser = Object::FindObjectOfType<PauseMenuManager*>())
+                pauser->MenuButtonPressed();
+            break;
+        case Action::Continue:
+            if (auto pauser = Object::FindObjectOfType<PauseMenuManager*>())
+                pauser->ContinueButtonPressed();
+            break;
+        default:
+            if (auto val = MovementAxis(action))
+                *val = 1;
+            break;
     }
-    auto upper = toupper(key[0]);
-    if (key.size() != 1)
-        upper = '\0';
-    if (upper == 'P') {
-        if (auto pauser = Object::FindObjectOfType<PauseController*>())
-            pauser->Pause();
-    } else if (upper == 'R') {
-        if (auto pauser = Object::FindObjectOfType<PauseMenuManager*>())
-            pauser->RestartButtonPressed();
-    } else if (upper == 'M') {
-        if (auto pauser = Object::FindObjectOfType<PauseMenuManager*>())
-            pauser->MenuButtonPressed();
-    } else if (upper == 'C') {
-        if (auto pauser = Object::FindObjectOfType<PauseMenuManager*>())
-            pauser->ContinueButtonPressed();
-    }
-    float* val = nullptr;
-    if (upper == 'W')
-        val = &movementF.z;
-    else if (upper == 'D')
-        val = &movementF.x;
-    else if (upper == 'E' || upper == ' ')
-        val = &movementF.y;
-    else if (upper == 'S')
-        val = &movementB.z;
-    else if (upper == 'A')
-        val = &movementB.x;
-    else if (upper == 'Q' || key == "Shift")
-        val = &movementB.y;
-    if (val)
-        *val = 1;
 }
 
-void FPFC::KeyUp(std::string const& key) {
+void FPFC::KeyUp(uint8_t key) {
     if (keyboardOpen)
         return;
-    auto upper = toupper(key[0]);
-    if (key.size() != 1)
-        upper = '\0';
-    float* val = nullptr;
-    if (upper == 'W')
-        val = &movementF.z;
-    else if (upper == 'D')
-        val = &movementF.x;
-    else if (upper == 'E' || upper == ' ')
-        val = &movementF.y;
-    else if (upper == 'S')
-        val = &movementB.z;
-    else if (upper == 'A')
-        val = &movementB.x;
-    else if (upper == 'Q' || key == "Shift")
-        val = &movementB.y;
-    if (val)
+    if (auto val = MovementAxis(KeyActions[key & 127]))
         *val = 0;
 }
 
+void FPFC::Type(char character) {
+    if (!keyboardOpen)
+        return;
+    if (character == '\b')
+        keyboardOpen->deleteButtonWasPressedEvent->Invoke();
+    else if (character == '\n')
+        keyboardOpen->okButtonWasPressedEvent->Invoke();
+    else
+        keyboardOpen->keyWasPressedEvent->Invoke(character);
+}
+
 void FPFC::MouseMove(Vector2 move) {
     move = Vector2::op_Division(move, 4);
     auto euler = rotation.eulerAngles;
@@ -3,6 +3,7 @@
 #include "GlobalNamespace/DeactivateVRControllersOnFocusCapture.hpp"
 #include "GlobalNamespace/MainCamera.hpp"
 #include "GlobalNamespace/OVRInput.hpp"
+#include "UnityEngine/Application.hpp"
 #include "UnityEngine/GameObject.hpp"
 #include "UnityEngine/SceneManagement/LoadSceneMode.hpp"
 #include "UnityEngine/SceneManagement/Scene.hpp"
@@ -15,9 +16,12 @@
 #include "fpfc.hpp"
 #include "hollywood/shared/hollywood.hpp"
 #include "hooks.hpp"
+#include "log.hpp"
 #include "manager.hpp"
 #include "metacore/shared/delegates.hpp"
 #include "metacore/shared/unity.hpp"
+#include "session.hpp"
+#include "trace.hpp"
 
 #if __has_include("bsml/shared/BSML.hpp")
 #include "bsml/shared/BSML.hpp"
@@ -47,10 +51,31 @@ MAKE_AUTO_HOOK_MATCH(
 
 static modloader::ModInfo modInfo = {MOD_ID, VERSION, 0};
 
+// forwards logs from the core to paper
+static void LogSink(Log::Level level, std::string const& message) {
+    switch (level) {
+        case Log::Level::Debug:
+            logger.debug("{}", message);
+            break;
+        case Log::Level::Info:
+            logger.info("{}", message);
+            break;
+        case Log::Level::Warn:
+            logger.warn("{}", message);
+            break;
+        case Log::Level::Error:
+            logger.error("{}", message);
+            break;
+    }
+}
+
 extern "C" void setup(CModInfo* info) {
     *info = modInfo.to_c();
 
     Paper::Logger::RegisterFileContextId(MOD_ID);
+    Log::SetSink(LogSink);
+    Trace::SetDirectory("/sdcard/ModData/com.beatgames.beatsaber/Mods/" MOD_ID "/traces");
+    Session::SetDirectory("/sdcard/ModData/com.beatgames.beatsaber/Mods/" MOD_ID "/sessions");
 
     getConfig().Init(modInfo);
 
@@ -60,6 +85,7 @@ extern "C" void setup(CModInfo* info) {
         logger.info("Resetting invalid port");
         getConfig().Port.SetValue(getConfig().Port.GetDefaultValue());
     }
+    Config::InitSnapshot();
 
     logger.info("Completed setup!");
 }
@@ -78,6 +104,13 @@ extern "C" void late_load() {
 
     MetaCore::Engine::ScheduleOnUpdate(Manager::Update);
 
+    // the process can be killed at any point while paused, so don't leave a debounced save pending
+    UnityEngine::Application::add_focusChanged(MetaCore::Delegates::MakeSystemAction([](bool focused) {
+        if (!focused)
+            Config::Flush();
+    }));
+    UnityEngine::Application::add_quitting(MetaCore::Delegates::MakeSystemAction([]() { Config::Flush(); }));
+
     Scenes::SceneManager::add_sceneLoaded(MetaCore::Delegates::MakeUnityAction([](Scenes::Scene, Scenes::LoadSceneMode) { FPFC::OnSceneChange(); }));
 
     Hooks::Install();
@@ -9,28 +9,45 @@
 #include "UnityEngine/StereoTargetEyeMask.hpp"
 #include "UnityEngine/Time.hpp"
 #include "UnityEngine/Transform.hpp"
+#include "accumulator.hpp"
 #include "audio.hpp"
+#include "bitrate.hpp"
 #include "config.hpp"
 #include "fpfc.hpp"
+#include "h264.hpp"
 #include "hollywood/shared/hollywood.hpp"
 #include "main.hpp"
 #include "math.hpp"
 #include "metacore/shared/input.hpp"
 #include "metacore/shared/unity.hpp"
+#include "metrics.hpp"
+#include "network.hpp"
+#include "packet.hpp"
+#include "pool.hpp"
+#include "session.hpp"
 #include "socket.hpp"
+#include "trace.hpp"
 
 static bool initialized = false;
 
 static Hollywood::CameraCapture* cameraStream = nullptr;
+static H264::Assembler assembler;
 static StreamMod::AudioCapture* audioStream = nullptr;
 static bool waiting = false;
 static bool capturing = false;
+// counts encoder restarts, to tell if one happened since a replay was requested
+static uint64_t restarts = 0;
+// start of the newest game frame, the closest to a capture time available for encoder output
+static std::atomic<uint64_t> renderTime = 0;
 
 static UnityEngine::Vector3 smoothPosition;
 static UnityEngine::Quaternion smoothRotation;
 
+static Packet::AudioSplitter audioSplitter;
+
+// monotonic, used for both audio and video timestamps
 static inline uint64_t Time() {
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 static void MakeCamera(UnityEngine::Camera* main) {
@@ -70,12 +87,16 @@ static void MakeCamera(UnityEngine::Camera* main) {
 
     cameraStream = camera->gameObject->AddComponent<Hollywood::CameraCapture*>();
     cameraStream->onOutputUnit = [](uint8_t* data, size_t length) {
-        static int frameIdx = 0;
-        PacketWrapper packet;
-        auto& video = *packet.mutable_videoframe();
-        *video.mutable_data() = {(char*) data, length};
-        video.set_time(Time());
-        Socket::Send(packet);
+        TRACE_SCOPE("onOutputUnit");
+        uint64_t time = Time();
+        if (Session::recording)
+            Session::Record(Session::Kind::VideoUnit, time, {data, length});
+        auto unit = assembler.Add({data, length});
+        if (!unit)
+            return;
+        auto serialized = Pool::Acquire(unit->parameterSets.size() + unit->data.size() + Packet::MaxVideoFrameOverhead);
+        Packet::WriteVideoFrame(serialized, unit->parameterSets, unit->data, time, unit->key);
+        Socket::SendVideo(std::move(serialized), unit->key, {.capture = renderTime, .encoded = time});
     };
 
     smoothPosition = main->transform->position;
@@ -85,6 +106,10 @@ static void MakeCamera(UnityEngine::Camera* main) {
     camera->gameObject->active = true;
 }
 
+static void QueueAudio(std::span<float> samples, int sampleRate, int channels) {
+    audioSplitter.Add(samples, sampleRate, channels, Config::GetSnapshot().audioPacketLength, Time(), Socket::SendAudioSamples);
+}
+
 static void RefreshAudio();
 
 static void MakeAudio(UnityEngine::AudioListener* listener) {
@@ -96,15 +121,7 @@ static void MakeAudio(UnityEngine::AudioListener* listener) {
     audioStream->onDisable = [](StreamMod::AudioCapture*) {
         MetaCore::Engine::ScheduleMainThread(RefreshAudio);  // since this destroys the component, we can't do it in the OnDisable callback
     };
-    audioStream->callback = [](std::span<float> samples, int sampleRate, int channels) {
-        PacketWrapper packet;
-        auto& audio = *packet.mutable_audioframe();
-        audio.set_channels(channels);
-        audio.set_samplerate(sampleRate);
-        audio.set_time(Time());
-        *audio.mutable_data() = {samples.begin(), samples.end()};
-        Socket::Send(packet);
-    };
+    audioStream->callback = QueueAudio;
     audioStream->SetMicCapture(getConfig().Mic.GetValue());
 }
 
@@ -112,6 +129,7 @@ static void StopAudio() {
     if (!audioStream)
         return;
     logger.debug("stopping audio capture");
+    audioSplitter.Reset();
     audioStream->OnDestroy();
     UnityEngine::Object::DestroyImmediate(audioStream);
     audioStream = nullptr;
@@ -134,8 +152,7 @@ void Manager::Init() {
     if (initialized)
         return;
 
-    Socket::Init();
-    Socket::Start();
+    Network::Init();
 
     getConfig().Mic.AddChangeEvent([](bool) { UpdateMic(); });
     getConfig().FPFC.AddChangeEvent([](bool val) {
@@ -150,17 +167,20 @@ void Manager::Init() {
     initialized = true;
 }
 
-void Manager::Update() {
+static void UpdateCamera() {
     if (!cameraStream)
         return;
-    if (getConfig().FPFC.GetValue()) {
+    if (capturing && Bitrate::Update())
+        Manager::RestartCapture();
+    auto config = Config::GetSnapshot();
+    if (config.fpfc) {
         cameraStream->transform->rotation = FPFC::GetRotation();
         cameraStream->transform->Translate(FPFC::GetMovement());
         FPFC::MoveControllers(cameraStream->transform);
         return;
     }
     auto pose = MetaCore::Input::GetHeadPose();
-    float smoothing = getConfig().Smoothing.GetValue();
+    float smoothing = config.smoothing;
     if (smoothing >= 0.1) {
         float deltaTime = UnityEngine::Time::get_deltaTime() * 2 / smoothing;
         smoothPosition = EaseLerp(smoothPosition, pose.position, UnityEngine::Time::get_time(), deltaTime);
@@ -172,6 +192,15 @@ void Manager::Update() {
     cameraStream->transform->SetPositionAndRotation(smoothPosition, smoothRotation);
 }
 
+void Manager::Update() {
+    TRACE_SCOPE("Manager::Update");
+    uint64_t start = Time();
+    renderTime = start;
+    Accumulator::Apply();
+    UpdateCamera();
+    Metrics::UpdateTime.Observe(Time() - start);
+}
+
 void Manager::Invalidate() {
     if (cameraStream)
         UnityEngine::Object::DestroyImmediate(cameraStream->gameObject);
@@ -192,37 +221,42 @@ void Manager::SetCamera(UnityEngine::Camera* main) {
     }
 }
 
-static void HandleSettings(Settings const& settings, void* source) {
-    getConfig().Width.SetValue(settings.horizontal(), false);
-    getConfig().Height.SetValue(settings.vertical(), false);
-    getConfig().Bitrate.SetValue(settings.bitrate(), false);
-    getConfig().FPS.SetValue(settings.fps(), false);
-    getConfig().FOV.SetValue(settings.fov(), false);
-    getConfig().Smoothing.SetValue(settings.smoothness(), false);
-    getConfig().Mic.SetValue(settings.mic(), false);
-    getConfig().FPFC.SetValue(settings.fpfc(), false);
-    getConfig().GameVolume.SetValue(settings.gamevolume(), false);
-    getConfig().MicVolume.SetValue(settings.micvolume(), false);
-    getConfig().MicThreshold.SetValue(settings.micthreshold(), false);
-    getConfig().MixMode.SetValue(settings.micmix(), false);
-    getConfig().Save();
-    Manager::UpdateSettings(source);
-    Config::UpdateMenu();
+// returns whether the value changed
+template <class C, class V>
+static bool SetIfChanged(C& config, V value) {
+    if (config.GetValue() == value)
+        return false;
+    Config::SetValue(config, value);
+    return true;
 }
 
-static void HandleInput(Input const& input) {
-    if (!getConfig().FPFC.GetValue())
+static void HandleSettings(Settings const& settings, void* source) {
+    if (settings.has_trace() && settings.trace())
+        Trace::Start();
+    else if (settings.has_trace())
+        Trace::Stop();
+
+    // clients send their settings back after receiving them, so most packets change nothing
+    bool restart = false;
+    restart |= SetIfChanged(getConfig().Width, (int) settings.horizontal());
+    restart |= SetIfChanged(getConfig().Height, (int) settings.vertical());
+    restart |= SetIfChanged(getConfig().Bitrate, (int) settings.bitrate());
+    restart |= SetIfChanged(getConfig().FPS, settings.fps());
+    restart |= SetIfChanged(getConfig().FOV, settings.fov());
+    // the rest are read live, or applied through change events
+    bool changed = restart;
+    changed |= SetIfChanged(getConfig().Smoothing, settings.smoothness());
+    changed |= SetIfChanged(getConfig().Mic, settings.mic());
+    changed |= SetIfChanged(getConfig().FPFC, settings.fpfc());
+    changed |= SetIfChanged(getConfig().GameVolume, settings.gamevolume());
+    changed |= SetIfChanged(getConfig().MicVolume, settings.micvolume());
+    changed |= SetIfChanged(getConfig().MicThreshold, settings.micthreshold());
+    changed |= SetIfChanged(getConfig().MixMode, (int) settings.micmix());
+    if (!changed)
         return;
-    FPFC::MouseMove({input.dx(), input.dy()});
-    if (input.mousedown())
-        FPFC::MouseDown();
-    if (input.mouseup())
-        FPFC::MouseUp();
-    FPFC::AddScroll(input.scroll());
-    for (auto& key : input.keysdown())
-        FPFC::KeyDown(key);
-    for (auto& key : input.keysup())
-        FPFC::KeyUp(key);
+
+    Manager::UpdateSettings(source, restart);
+    Config::UpdateMenu();
 }
 
 void Manager::HandleMessage(PacketWrapper const& packet, void* source) {
@@ -230,15 +264,12 @@ void Manager::HandleMessage(PacketWrapper const& packet, void* source) {
         case PacketWrapper::kSettings:
             HandleSettings(packet.settings(), source);
             break;
-        case PacketWrapper::kInput:
-            HandleInput(packet.input());
-            break;
         default:
             break;
     }
 }
 
-void Manager::UpdateSettings(void* source) {
+static PacketWrapper GetSettings() {
     PacketWrapper packet;
     auto& settings = *packet.mutable_settings();
     settings.set_horizontal(getConfig().Width.GetValue());
@@ -253,9 +284,36 @@ void Manager::UpdateSettings(void* source) {
     settings.set_micvolume(getConfig().MicVolume.GetValue());
     settings.set_micthreshold(getConfig().MicThreshold.GetValue());
     settings.set_micmix(getConfig().MixMode.GetValue());
+    settings.set_trace(Trace::enabled);
+    return packet;
+}
+
+void Manager::UpdateSettings(void* source, bool restart) {
     logger.debug("sending settings except to {}", source);
-    Socket::Send(packet, source);
-    RestartCapture();  // at least for now, clients will always expect new video streams after sending or receiving settings
+    Socket::Send(GetSettings(), source);
+    // hollywood can't change the resolution, fov, bitrate, or fps of a running encoder
+    if (restart) {
+        Bitrate::Reset();
+        RestartCapture();
+    }
+}
+
+void Manager::AddViewer(void* connection) {
+    logger.debug("sending settings to {}", connection);
+    Socket::SendTo(GetSettings(), connection);
+    // keep the encoder running for existing viewers if possible
+    if (capturing && cameraStream && Socket::HasCachedVideo()) {
+        Socket::SendCachedVideo(connection, [connection, requested = restarts]() {
+            MetaCore::Engine::ScheduleMainThread([connection, requested]() {
+                // a restart since then sends a key frame to everyone anyway
+                if (capturing && restarts == requested) {
+                    logger.debug("no cached video left for {}", connection);
+                    RestartCapture();
+                }
+            });
+        });
+    } else
+        RestartCapture();
 }
 
 bool Manager::IsCapturing() {
@@ -273,13 +331,17 @@ void Manager::RestartCapture() {
     }
     logger.info("refreshing capture");
     cameraStream->Stop();
+    Socket::ClearCachedVideo();
+    assembler.Reset();
     cameraStream->Init(
         getConfig().Width.GetValue(),
         getConfig().Height.GetValue(),
         getConfig().FPS.GetValue(),
-        getConfig().Bitrate.GetValue() * 1000,
+        Bitrate::Get() * 1000,
         getConfig().FOV.GetValue()
     );
+    Metrics::EncoderRestarts.Add();
+    restarts++;
     if (!audioStream)
         RefreshAudio();
     FPFC::GetControllers();
@@ -291,8 +353,10 @@ void Manager::StopCapture() {
     logger.info("stopping capture");
     if (cameraStream)
         cameraStream->Stop();
+    Socket::ClearCachedVideo();
     StopAudio();
     FPFC::ReleaseControllers();
+    Config::Flush();
     waiting = false;
     capturing = false;
 }
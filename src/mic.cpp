@@ -6,6 +6,8 @@
 #include "UnityEngine/GameObject.hpp"
 #include "config.hpp"
 #include "main.hpp"
+#include "mixing.hpp"
+#include "trace.hpp"
 
 DEFINE_TYPE(StreamMod, MicCapture);
 
@@ -42,13 +44,8 @@ static void EndRecord(int deviceId) {
 }
 
 static float GetLoudness(ArrayW<float> data) {
-    // root mean square - maybe use some sort of weighting filter in the future?
-    // https://community.vcvrack.com/t/complete-list-of-native-fft-libraries-for-audio/9153
-    float sum = 0;
-    for (int i = 0; i < data.size(); i++)
-        sum += data[i] * data[i];
     // apply a boost to make 0-2 a good range (why so much? idk)
-    return sqrt(sum / data.size()) * getConfig().MicVolume.GetValue() * 100;
+    return Mixing::Loudness(data.begin(), data.size()) * Config::GetSnapshot().micVolume * 100;
 }
 
 void MicCapture::Init() {
@@ -101,6 +98,7 @@ void MicCapture::Stop() {
 }
 
 void MicCapture::OnAudioFilterRead(ArrayW<float> data, int audioChannels) {
+    TRACE_SCOPE("MicCapture::OnAudioFilterRead");
     channels = audioChannels;
     if (sampleRate != -1 && callback) {
         float newLoudness = GetLoudness(data);
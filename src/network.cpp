@@ -0,0 +1,63 @@
+#include "network.hpp"
+
+#include "accumulator.hpp"
+#include "config.hpp"
+#include "main.hpp"
+#include "manager.hpp"
+#include "metacore/shared/unity.hpp"
+#include "metrics.hpp"
+#include "socket.hpp"
+#include "trace.hpp"
+
+static bool initialized = false;
+
+// runs func on the main thread, recording how long it waited
+static void Dispatch(std::function<void()> func) {
+    uint64_t scheduled = Trace::Now();
+    MetaCore::Engine::ScheduleMainThread([scheduled, func = std::move(func)]() {
+        Metrics::DispatchLag.Observe(Trace::Now() - scheduled);
+        func();
+    });
+}
+
+// a viewer may have connected again before this ran
+static void StopIfEmpty() {
+    if (!Socket::HasConnections())
+        Manager::StopCapture();
+}
+
+static bool Start() {
+    return Socket::Start(std::stoi(getConfig().Port.GetValue()));
+}
+
+void Network::Init() {
+    if (initialized)
+        return;
+
+    Socket::Init({
+        .open = [](void* connection) { Dispatch([connection]() { Manager::AddViewer(connection); }); },
+        .empty = []() { Dispatch(StopIfEmpty); },
+        .message =
+            [](PacketWrapper packet, void* source) {
+                Dispatch([packet = std::move(packet), source]() { Manager::HandleMessage(packet, source); });
+            },
+        // applied once per frame instead of scheduling a task for each packet
+        .input = Accumulator::Add,
+    });
+    Start();
+
+    initialized = true;
+}
+
+void Network::Refresh(std::function<void(bool)> done) {
+    if (done)
+        Stop([done]() { done(Start()); });
+    else
+        Stop(Start);
+}
+
+void Network::Stop(std::function<void()> stopped) {
+    Socket::Stop();
+    if (stopped)
+        MetaCore::Engine::ScheduleMainThread([]() { return !Socket::IsRunning(); }, stopped);
+}